@@ -0,0 +1,68 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   BufferPool.cxx
+
+#include "MFTTestwf/BufferPool.h"
+
+#include "FairLogger.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+void BufferPool::beginTimeframe()
+{
+  bool endOfWindow = mTrimWindow > 0 && mNTFs > 0 && (mNTFs % mTrimWindow) == 0;
+  for (auto& b : mBuffers) {
+    b.clear();
+    if (endOfWindow) {
+      if (b.capacity() > mTrimFactor * b.highWater) {
+        b.trim(b.highWater);
+        mNAllocations++;
+      }
+      b.highWater = 0;
+    }
+    b.startCapacity = b.capacity();
+  }
+}
+
+void BufferPool::endTimeframe()
+{
+  mNAllocationsLastTF = 0;
+  for (auto& b : mBuffers) {
+    if (b.capacity() != b.startCapacity) {
+      mNAllocationsLastTF++;
+    }
+    b.highWater = std::max(b.highWater, b.size());
+  }
+  mNAllocations += mNAllocationsLastTF;
+  mNTFs++;
+}
+
+size_t BufferPool::getReservedBytes() const
+{
+  size_t bytes = 0;
+  for (const auto& b : mBuffers) {
+    bytes += b.capacity() * b.elementSize;
+  }
+  return bytes;
+}
+
+void BufferPool::print(const std::string& device) const
+{
+  LOG(INFO) << device << " buffers grew " << mNAllocationsLastTF << " times in the last timeframe, "
+            << mNAllocations << " times in " << mNTFs << " timeframes, "
+            << getReservedBytes() << " bytes reserved";
+}
+
+} // namespace MFT
+} // namespace o2
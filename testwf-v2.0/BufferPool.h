@@ -0,0 +1,92 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   BufferPool.h
+
+#ifndef O2_MFT_BUFFERPOOL_H_
+#define O2_MFT_BUFFERPOOL_H_
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+
+namespace o2
+{
+namespace MFT
+{
+
+/// working buffers of a device kept across timeframes: they are cleared,
+/// not freed, at the start of each timeframe and the pool counts the
+/// timeframes in which a buffer had to grow; every trimWindow timeframes,
+/// a buffer larger than trimFactor times its high-water mark over the
+/// window is shrunk back to the high-water mark
+class BufferPool
+{
+ public:
+  void setTrimPolicy(float factor, int window)
+  {
+    mTrimFactor = factor;
+    mTrimWindow = window;
+  }
+
+  /// register a buffer, which must outlive the pool
+  template <typename T>
+  void add(std::vector<T>& v, const std::string& name)
+  {
+    Buffer b;
+    b.name = name;
+    b.elementSize = sizeof(T);
+    b.size = [&v]() { return v.size(); };
+    b.capacity = [&v]() { return v.capacity(); };
+    b.clear = [&v]() { v.clear(); };
+    b.trim = [&v](size_t n) {
+      std::vector<T> tmp;
+      tmp.reserve(n);
+      v.swap(tmp);
+    };
+    mBuffers.push_back(b);
+  }
+
+  /// clear the buffers, trimming them first at the end of a window
+  void beginTimeframe();
+  /// count the buffers which have grown and update the high-water marks
+  void endTimeframe();
+
+  size_t getNAllocations() const { return mNAllocations; }
+  size_t getNAllocationsLastTF() const { return mNAllocationsLastTF; }
+  /// bytes reserved by all the buffers
+  size_t getReservedBytes() const;
+  void print(const std::string& device) const;
+
+ private:
+  struct Buffer {
+    std::string name;
+    size_t elementSize = 0;
+    size_t startCapacity = 0; ///< capacity at the start of the timeframe
+    size_t highWater = 0;     ///< largest size over the current window
+    std::function<size_t()> size;
+    std::function<size_t()> capacity;
+    std::function<void()> clear;
+    std::function<void(size_t)> trim;
+  };
+
+  float mTrimFactor = 2.f;
+  int mTrimWindow = 0; ///< 0 for no trimming
+  int mNTFs = 0;
+  size_t mNAllocations = 0;
+  size_t mNAllocationsLastTF = 0;
+  std::vector<Buffer> mBuffers;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_BUFFERPOOL */
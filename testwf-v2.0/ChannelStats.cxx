@@ -0,0 +1,62 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ChannelStats.cxx
+
+#include <algorithm>
+
+#include "MFTTestwf/ChannelStats.h"
+
+#include "Headers/DataHeader.h"
+#include "FairLogger.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+void ChannelStats::account(o2::framework::InputRecord& inputs)
+{
+  if (!mEnabled) {
+    return;
+  }
+  for (auto const& ref : inputs) {
+    auto const* dh = o2::header::get<o2::header::DataHeader*>(ref.header);
+    if (!dh) {
+      continue;
+    }
+    auto name = dh->dataOrigin.as<std::string>() + "/" + dh->dataDescription.as<std::string>() + "/" +
+                std::to_string(dh->subSpecification);
+    auto route = std::find_if(mRoutes.begin(), mRoutes.end(), [&name](const Route& r) { return r.name == name; });
+    if (route == mRoutes.end()) {
+      mRoutes.emplace_back();
+      route = mRoutes.end() - 1;
+      route->name = name;
+    }
+    route->bytes += dh->payloadSize;
+    route->messages++;
+  }
+}
+
+void ChannelStats::print(const std::string& device) const
+{
+  if (!mEnabled) {
+    return;
+  }
+  size_t total = 0;
+  for (const auto& r : mRoutes) {
+    LOG(INFO) << device << " received " << r.bytes << " bytes in " << r.messages << " messages from " << r.name;
+    total += r.bytes;
+  }
+  LOG(INFO) << device << " received " << total << " bytes in total";
+}
+
+} // namespace MFT
+} // namespace o2
@@ -0,0 +1,51 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ChannelStats.h
+
+#ifndef O2_MFT_CHANNELSTATS_H_
+#define O2_MFT_CHANNELSTATS_H_
+
+#include <string>
+#include <vector>
+
+#include "Framework/InputRecord.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// bytes and messages received by a device, per input route
+/// (data origin, description and subSpec)
+class ChannelStats
+{
+ public:
+  void setEnabled(bool v) { mEnabled = v; }
+  bool isEnabled() const { return mEnabled; }
+
+  /// account the payloads of all the inputs of a timeframe
+  void account(o2::framework::InputRecord& inputs);
+  void print(const std::string& device) const;
+
+ private:
+  struct Route {
+    std::string name;
+    size_t bytes = 0;
+    size_t messages = 0;
+  };
+  bool mEnabled = false;
+  std::vector<Route> mRoutes;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_CHANNELSTATS */
@@ -0,0 +1,137 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   Checkpoint.cxx
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "MFTTestwf/Checkpoint.h"
+
+#include "FairLogger.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+namespace
+{
+/// write the whole buffer and sync it to the disk
+bool writeSynced(int fd, const std::string& data)
+{
+  size_t pos = 0;
+  while (pos < data.size()) {
+    auto n = ::write(fd, data.data() + pos, data.size() - pos);
+    if (n < 0) {
+      return false;
+    }
+    pos += n;
+  }
+  return ::fsync(fd) == 0;
+}
+
+/// sync the directory entry of a renamed file
+bool syncDirectory(const std::string& name)
+{
+  auto slash = name.rfind('/');
+  auto dir = slash == std::string::npos ? std::string(".") : name.substr(0, slash + 1);
+  int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+} // namespace
+
+bool Checkpoint::write(const std::string& name) const
+{
+  std::ostringstream out;
+  out << "# cluster production progress\n"
+      << "outfile " << outFile << '\n'
+      << "ntfs " << nTFs << '\n'
+      << "written " << nWritten << '\n'
+      << "entries " << nEntries << '\n'
+      << "nextrof " << nextROF << '\n'
+      << "readers " << nReaders << '\n';
+
+  // the content is on the disk before the rename makes it the manifest
+  auto tmpName = name + ".tmp";
+  int fd = ::open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  bool ok = fd >= 0 && writeSynced(fd, out.str());
+  if (fd >= 0) {
+    ok = (::close(fd) == 0) && ok;
+  }
+  if (!ok) {
+    LOG(ERROR) << "Cannot write the progress manifest " << tmpName.c_str() << " !";
+    return false;
+  }
+  if (std::rename(tmpName.c_str(), name.c_str()) != 0) {
+    LOG(ERROR) << "Cannot rename the progress manifest " << tmpName.c_str() << " to " << name.c_str() << " !";
+    return false;
+  }
+  if (!syncDirectory(name)) {
+    LOG(ERROR) << "Cannot sync the directory of the progress manifest " << name.c_str() << " !";
+    return false;
+  }
+  return true;
+}
+
+bool Checkpoint::read(const std::string& name)
+{
+  std::ifstream in(name);
+  if (!in.good()) {
+    return false;
+  }
+  int nKeys = 0;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+    if (key == "outfile") {
+      std::getline(fields >> std::ws, outFile); // the rest of the line, the name may hold spaces
+    } else if (key == "ntfs") {
+      fields >> nTFs;
+    } else if (key == "written") {
+      fields >> nWritten;
+    } else if (key == "entries") {
+      fields >> nEntries;
+    } else if (key == "nextrof") {
+      fields >> nextROF;
+    } else if (key == "readers") {
+      fields >> nReaders;
+    } else {
+      continue;
+    }
+    if (fields.fail()) {
+      LOG(ERROR) << "Cannot parse the line \"" << line.c_str() << "\" of the progress manifest " << name.c_str() << " !";
+      return false;
+    }
+    nKeys++;
+  }
+  if (nKeys != 6) {
+    LOG(ERROR) << "The progress manifest " << name.c_str() << " is incomplete !";
+    return false;
+  }
+  return true;
+}
+
+} // namespace MFT
+} // namespace o2
@@ -0,0 +1,49 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   Checkpoint.h
+
+#ifndef O2_MFT_CHECKPOINT_H_
+#define O2_MFT_CHECKPOINT_H_
+
+#include <cstdint>
+#include <string>
+
+namespace o2
+{
+namespace MFT
+{
+
+/// progress manifest of the cluster production: the cluster writer rewrites
+/// it each time a chunk of timeframes is committed to its output file, the
+/// digit readers (and the digit merger) read it back to resume the
+/// production at the first timeframe not committed
+struct Checkpoint {
+  std::string outFile;   ///< cluster file holding the committed timeframes
+  uint32_t nTFs = 0;     ///< number of timeframes in the run
+  uint32_t nWritten = 0; ///< number of timeframes committed, the first one to read again
+  uint32_t nEntries = 0; ///< number of tree entries committed
+  uint32_t nextROF = 0;  ///< first free RO frame after the committed timeframes
+  uint32_t nReaders = 1; ///< number of digit readers sharing the input files
+
+  bool isComplete() const { return nTFs > 0 && nWritten >= nTFs; }
+
+  /// write the manifest in a temporary file synced and renamed over name,
+  /// the directory synced after the rename: a crash leaves either the
+  /// previous manifest or the new one
+  bool write(const std::string& name) const;
+  /// false if the manifest does not exist or cannot be parsed
+  bool read(const std::string& name);
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_CHECKPOINT */
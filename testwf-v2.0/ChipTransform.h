@@ -0,0 +1,122 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ChipTransform.h
+
+#ifndef O2_MFT_CHIPTRANSFORM_H_
+#define O2_MFT_CHIPTRANSFORM_H_
+
+#include <vector>
+#include <algorithm>
+
+#include "MathUtils/Cartesian3D.h"
+#include "DataFormatsITSMFT/Cluster.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// positions of a set of points in structure-of-arrays form
+struct ClusterCoordinates {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+
+  void resize(size_t n)
+  {
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+  }
+  void clear()
+  {
+    x.clear();
+    y.clear();
+    z.clear();
+  }
+  size_t size() const { return x.size(); }
+};
+
+/// 3x4 matrix of a chip applied to batches of points: the coefficients are
+/// held in registers and the loop over the points vectorizes, instead of
+/// one matrix multiplication per point
+class ChipTransform
+{
+ public:
+  ChipTransform() = default;
+  explicit ChipTransform(const o2::Transform3D& mat) { set(mat); }
+
+  void set(const o2::Transform3D& mat)
+  {
+    double m[12];
+    mat.GetComponents(m);
+    std::copy(m, m + 12, mM);
+  }
+
+  /// transform n points, the output arrays may be the input ones
+  void apply(const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t n) const
+  {
+    const float m0 = mM[0], m1 = mM[1], m2 = mM[2], m3 = mM[3];
+    const float m4 = mM[4], m5 = mM[5], m6 = mM[6], m7 = mM[7];
+    const float m8 = mM[8], m9 = mM[9], m10 = mM[10], m11 = mM[11];
+    for (size_t i = 0; i < n; i++) {
+      const float xi = x[i], yi = y[i], zi = z[i];
+      ox[i] = m0 * xi + m1 * yi + m2 * zi + m3;
+      oy[i] = m4 * xi + m5 * yi + m6 * zi + m7;
+      oz[i] = m8 * xi + m9 * yi + m10 * zi + m11;
+    }
+  }
+
+ private:
+  float mM[12] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+};
+
+/// positions of the clusters, given in the tracking frame, transformed with
+/// the matrix of their chip returned by getMatrix(chipID), e.g. the T2L or
+/// T2G matrices of the geometry, into the x, y and z arrays of n clusters
+/// (e.g. the blocks of an output message); the clusters of a chip are
+/// consecutive in the clusterer output and are transformed in one batch
+template <typename MatrixGetter>
+void transformClusters(const std::vector<o2::ITSMFT::Cluster>& clusters, MatrixGetter getMatrix,
+                       float* x, float* y, float* z)
+{
+  size_t n = clusters.size();
+  for (size_t i = 0; i < n; i++) {
+    x[i] = clusters[i].getX();
+    y[i] = clusters[i].getY();
+    z[i] = clusters[i].getZ();
+  }
+  ChipTransform transform;
+  for (size_t first = 0; first < n;) {
+    auto chip = clusters[first].getSensorID();
+    size_t last = first + 1;
+    while (last < n && clusters[last].getSensorID() == chip) {
+      last++;
+    }
+    transform.set(getMatrix(chip));
+    transform.apply(x + first, y + first, z + first, x + first, y + first, z + first, last - first);
+    first = last;
+  }
+}
+
+/// same, into the arrays of out, resized to the number of clusters
+template <typename MatrixGetter>
+void transformClusters(const std::vector<o2::ITSMFT::Cluster>& clusters, MatrixGetter getMatrix,
+                       ClusterCoordinates& out)
+{
+  out.resize(clusters.size());
+  transformClusters(clusters, getMatrix, out.x.data(), out.y.data(), out.z.data());
+}
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_CHIPTRANSFORM */
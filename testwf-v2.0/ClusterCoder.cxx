@@ -0,0 +1,319 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ClusterCoder.cxx
+
+#include <algorithm>
+#include <numeric>
+
+#include "MFTTestwf/ClusterCoder.h"
+
+#include "FairLogger.h"
+
+using namespace o2::ITSMFT;
+
+namespace o2
+{
+namespace MFT
+{
+
+namespace
+{
+constexpr uint32_t RansLow = 1u << 23;  ///< lower bound of the rANS state
+constexpr double EscapeProbability = 1. / 256;
+
+void putVarint(std::vector<uint8_t>& out, uint32_t v)
+{
+  while (v >= 0x80) {
+    out.push_back(uint8_t(v) | 0x80);
+    v >>= 7;
+  }
+  out.push_back(uint8_t(v));
+}
+
+bool getVarint(gsl::span<const uint8_t> in, size_t& pos, uint32_t& v)
+{
+  v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (pos >= size_t(in.size())) {
+      return false;
+    }
+    uint8_t b = in[pos++];
+    v |= uint32_t(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t v)
+{
+  for (int i = 0; i < 4; i++) {
+    out.push_back(uint8_t(v >> (8 * i)));
+  }
+}
+
+bool get32(gsl::span<const uint8_t> in, size_t& pos, uint32_t& v)
+{
+  if (pos + 4 > size_t(in.size())) {
+    return false;
+  }
+  v = 0;
+  for (int i = 0; i < 4; i++) {
+    v |= uint32_t(in[pos++]) << (8 * i);
+  }
+  return true;
+}
+
+inline uint32_t zigzag(int32_t v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+inline int32_t unzigzag(uint32_t v) { return int32_t(v >> 1) ^ -int32_t(v & 1); }
+
+/// position of a cluster in the encoding order
+inline uint64_t sortKey(const CompClusterExt& c)
+{
+  return (uint64_t(c.getChipID()) << 19) | (uint64_t(c.getCol()) << 9) | c.getRow();
+}
+} // namespace
+
+bool ClusterCoder::setDictionary(const TopologyDictionary* dict)
+{
+  // the dictionary lists the patterns by decreasing frequency, the rarest
+  // ones beyond MaxPatterns go to the escape
+  int nDictPatterns = dict ? dict->GetSize() : 0;
+  int nPatterns = std::min(nDictPatterns, MaxPatterns);
+  int nSymbols = nPatterns + 1;
+  std::vector<double> prob(nSymbols);
+  double sum = 0., escaped = 0.;
+  for (int i = 0; i < nPatterns; i++) {
+    prob[i] = dict->GetFrequency(i);
+    sum += prob[i];
+  }
+  for (int i = nPatterns; i < nDictPatterns; i++) {
+    escaped += dict->GetFrequency(i);
+  }
+  // the escape takes a fixed share of the probability
+  prob[nPatterns] = nPatterns ? EscapeProbability * sum + escaped : 1.;
+  sum += prob[nPatterns];
+
+  // quantize to ProbScale, keeping every symbol encodable
+  mFreq.assign(nSymbols, 1);
+  int64_t total = 0;
+  for (int i = 0; i < nSymbols; i++) {
+    mFreq[i] = std::max(1u, uint32_t(prob[i] / sum * ProbScale));
+    total += mFreq[i];
+  }
+  int64_t diff = int64_t(ProbScale) - total;
+  while (diff != 0) {
+    auto big = std::max_element(mFreq.begin(), mFreq.end()) - mFreq.begin();
+    int64_t step = diff > 0 ? diff : -std::min<int64_t>(-diff, mFreq[big] - 1);
+    if (step == 0) {
+      break; // every symbol is down to one slot
+    }
+    mFreq[big] += step;
+    diff -= step;
+  }
+  if (diff != 0) {
+    LOG(ERROR) << "ClusterCoder cannot fit the " << nSymbols << " symbols of the dictionary in " << ProbScale
+               << " slots, the patterns are all escaped !";
+    setDictionary(nullptr);
+    return false;
+  }
+
+  mStart.resize(nSymbols);
+  mSymbols.resize(ProbScale);
+  uint32_t start = 0;
+  mTableHash = 2166136261u; // FNV-1a
+  for (int i = 0; i < nSymbols; i++) {
+    mStart[i] = start;
+    std::fill(mSymbols.begin() + start, mSymbols.begin() + start + mFreq[i], uint16_t(i));
+    start += mFreq[i];
+    mTableHash = (mTableHash ^ mFreq[i]) * 16777619u;
+  }
+  return true;
+}
+
+bool ClusterCoder::encode(const std::vector<CompClusterExt>& clusters, const std::vector<uint32_t>& rofs,
+                          std::vector<uint8_t>& out, std::vector<int>& order) const
+{
+  out.clear();
+  order.clear();
+  if (rofs.size() != clusters.size()) {
+    LOG(ERROR) << "ClusterCoder got " << rofs.size() << " RO frames for " << clusters.size() << " clusters !";
+    return false;
+  }
+
+  auto less = [&clusters, &rofs](int a, int b) {
+    return rofs[a] != rofs[b] ? rofs[a] < rofs[b] : sortKey(clusters[a]) < sortKey(clusters[b]);
+  };
+  size_t n = clusters.size();
+  bool sorted = true;
+  for (size_t i = 1; i < n && sorted; i++) {
+    sorted = !less(i, i - 1);
+  }
+  if (!sorted) {
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), less);
+  }
+  auto index = [&order, sorted](size_t i) { return sorted ? int(i) : order[i]; };
+
+  std::vector<uint8_t> chips, positions;
+  std::vector<uint16_t> symbols, escapes;
+  symbols.reserve(n);
+  uint32_t nChips = 0, lastROF = 0, lastChip = 0;
+  int escape = mFreq.size() - 1;
+  for (size_t i = 0; i < n;) {
+    // one record per chip and RO frame
+    const auto& first = clusters[index(i)];
+    uint32_t rof = rofs[index(i)];
+    uint32_t chip = first.getChipID();
+    size_t end = i + 1;
+    while (end < n && rofs[index(end)] == rof && clusters[index(end)].getChipID() == chip) {
+      end++;
+    }
+    putVarint(chips, rof - lastROF);
+    putVarint(chips, (nChips && rof == lastROF) ? chip - lastChip : chip);
+    putVarint(chips, end - i);
+    lastROF = rof;
+    lastChip = chip;
+    nChips++;
+
+    int lastCol = 0, lastRow = 0;
+    for (; i < end; i++) {
+      const auto& c = clusters[index(i)];
+      putVarint(positions, c.getCol() - lastCol);
+      putVarint(positions, zigzag(int(c.getRow()) - lastRow));
+      lastCol = c.getCol();
+      lastRow = c.getRow();
+      int patt = c.getPatternID();
+      if (patt < escape) {
+        symbols.push_back(patt);
+      } else {
+        symbols.push_back(escape);
+        escapes.push_back(patt);
+      }
+    }
+  }
+
+  // rANS, the symbols are coded backwards and the bytes reversed at the end,
+  // for the decoder to read them forwards
+  std::vector<uint8_t> patterns;
+  uint32_t x = RansLow;
+  for (size_t i = symbols.size(); i--;) {
+    uint32_t freq = mFreq[symbols[i]];
+    uint32_t xMax = ((RansLow >> ProbBits) << 8) * freq;
+    while (x >= xMax) {
+      patterns.push_back(uint8_t(x));
+      x >>= 8;
+    }
+    x = ((x / freq) << ProbBits) + (x % freq) + mStart[symbols[i]];
+  }
+  for (int i = 3; i >= 0; i--) {
+    patterns.push_back(uint8_t(x >> (8 * i)));
+  }
+  std::reverse(patterns.begin(), patterns.end());
+
+  put32(out, n);
+  put32(out, nChips);
+  put32(out, mTableHash);
+  put32(out, chips.size());
+  put32(out, positions.size());
+  put32(out, patterns.size());
+  put32(out, escapes.size());
+  out.insert(out.end(), chips.begin(), chips.end());
+  out.insert(out.end(), positions.begin(), positions.end());
+  out.insert(out.end(), patterns.begin(), patterns.end());
+  for (auto e : escapes) {
+    out.push_back(uint8_t(e));
+    out.push_back(uint8_t(e >> 8));
+  }
+  return true;
+}
+
+bool ClusterCoder::decode(gsl::span<const uint8_t> in, std::vector<CompClusterExt>& clusters,
+                          std::vector<uint32_t>& rofs) const
+{
+  clusters.clear();
+  rofs.clear();
+
+  size_t pos = 0;
+  uint32_t n, nChips, hash, nChipBytes, nPosBytes, nPattBytes, nEscapes;
+  if (!get32(in, pos, n) || !get32(in, pos, nChips) || !get32(in, pos, hash) || !get32(in, pos, nChipBytes) ||
+      !get32(in, pos, nPosBytes) || !get32(in, pos, nPattBytes) || !get32(in, pos, nEscapes) ||
+      pos + nChipBytes + nPosBytes + nPattBytes + 2 * size_t(nEscapes) != size_t(in.size())) {
+    LOG(ERROR) << "ClusterCoder got truncated cluster data !";
+    return false;
+  }
+  if (hash != mTableHash) {
+    LOG(ERROR) << "ClusterCoder got clusters encoded with another topology dictionary !";
+    return false;
+  }
+  auto chips = in.subspan(pos, nChipBytes);
+  auto positions = in.subspan(pos + nChipBytes, nPosBytes);
+  auto patterns = in.subspan(pos + nChipBytes + nPosBytes, nPattBytes);
+  auto escapes = in.subspan(pos + nChipBytes + nPosBytes + nPattBytes, 2 * size_t(nEscapes));
+
+  clusters.reserve(n);
+  rofs.reserve(n);
+  size_t chipPos = 0, posPos = 0, pattPos = 0, escPos = 0;
+  uint32_t x = 0;
+  if (!get32(patterns, pattPos, x)) {
+    LOG(ERROR) << "ClusterCoder got truncated pattern IDs !";
+    return false;
+  }
+  int escape = mFreq.size() - 1;
+  uint32_t rof = 0, chip = 0;
+  for (uint32_t ic = 0; ic < nChips; ic++) {
+    uint32_t dROF, dChip, nInChip;
+    if (!getVarint(chips, chipPos, dROF) || !getVarint(chips, chipPos, dChip) || !getVarint(chips, chipPos, nInChip)) {
+      LOG(ERROR) << "ClusterCoder got truncated chip records !";
+      return false;
+    }
+    chip = (ic && dROF == 0) ? chip + dChip : dChip;
+    rof += dROF;
+    int col = 0, row = 0;
+    for (uint32_t i = 0; i < nInChip; i++) {
+      uint32_t dCol, dRow;
+      if (!getVarint(positions, posPos, dCol) || !getVarint(positions, posPos, dRow)) {
+        LOG(ERROR) << "ClusterCoder got truncated cluster positions !";
+        return false;
+      }
+      col += dCol;
+      row += unzigzag(dRow);
+
+      uint32_t slot = x & (ProbScale - 1);
+      int s = mSymbols[slot];
+      x = mFreq[s] * (x >> ProbBits) + slot - mStart[s];
+      while (x < RansLow && pattPos < size_t(patterns.size())) {
+        x = (x << 8) | patterns[pattPos++];
+      }
+      int patt = s;
+      if (s == escape) {
+        if (escPos + 2 > size_t(escapes.size())) {
+          LOG(ERROR) << "ClusterCoder got truncated escaped pattern IDs !";
+          return false;
+        }
+        patt = escapes[escPos] | (escapes[escPos + 1] << 8);
+        escPos += 2;
+      }
+      clusters.emplace_back(row, col, patt, chip);
+      rofs.push_back(rof);
+    }
+  }
+  if (clusters.size() != n) {
+    LOG(ERROR) << "ClusterCoder decoded " << clusters.size() << " clusters instead of " << n << " !";
+    return false;
+  }
+  return true;
+}
+
+} // namespace MFT
+} // namespace o2
@@ -0,0 +1,79 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ClusterCoder.h
+
+#ifndef O2_MFT_CLUSTERCODER_H_
+#define O2_MFT_CLUSTERCODER_H_
+
+#include <vector>
+#include <cstdint>
+
+#include <gsl/span>
+
+#include "DataFormatsITSMFT/CompCluster.h"
+#include "DataFormatsITSMFT/TopologyDictionary.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// lossless compact encoding of the compact clusters of a timeframe:
+/// - the clusters are sorted by RO frame, chip, column and row
+/// - one record per fired chip: RO frame delta, chip ID (delta within the
+///   RO frame) and number of clusters, as variable-length integers
+/// - per cluster: column delta and zigzag row delta within the chip,
+///   as variable-length integers
+/// - pattern IDs: rANS coded with the topology frequencies of the
+///   dictionary, the IDs out of the dictionary are escaped and kept as such
+/// The decoder must use the same dictionary as the encoder, this is checked
+/// with a hash of the frequency table stored in the encoded data.
+class ClusterCoder
+{
+ public:
+  static constexpr int ProbBits = 16;
+  static constexpr uint32_t ProbScale = 1u << ProbBits;
+  /// patterns of the dictionary with a symbol of their own, the rarer ones
+  /// are escaped; every symbol takes at least one of the ProbScale slots
+  static constexpr int MaxPatterns = ProbScale / 4;
+
+  ClusterCoder() { setDictionary(nullptr); }
+
+  /// build the frequency table of the pattern IDs, all the patterns are
+  /// escaped without a dictionary; false if the table of the dictionary
+  /// cannot be quantized, the patterns are then all escaped
+  bool setDictionary(const o2::ITSMFT::TopologyDictionary* dict);
+
+  /// encode the clusters, rofs giving the RO frame of each cluster; when the
+  /// clusters are reordered, "order" is filled with the source index of each
+  /// encoded cluster, it is left empty if they are already in the encoded
+  /// order; false, with "out" empty, if the clusters cannot be encoded
+  bool encode(const std::vector<o2::ITSMFT::CompClusterExt>& clusters, const std::vector<uint32_t>& rofs,
+              std::vector<uint8_t>& out, std::vector<int>& order) const;
+
+  /// decode the clusters and their RO frames, in the encoded order
+  bool decode(gsl::span<const uint8_t> in, std::vector<o2::ITSMFT::CompClusterExt>& clusters,
+              std::vector<uint32_t>& rofs) const;
+
+  int getNSymbols() const { return mFreq.size(); }
+  uint32_t getTableHash() const { return mTableHash; }
+
+ private:
+  std::vector<uint32_t> mFreq;     ///< quantized frequency of each symbol, the escape is the last
+  std::vector<uint32_t> mStart;    ///< cumulated frequency
+  std::vector<uint16_t> mSymbols;  ///< symbol of each of the ProbScale slots
+  uint32_t mTableHash = 0;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_CLUSTERCODER */
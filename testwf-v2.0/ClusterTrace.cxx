@@ -0,0 +1,238 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ClusterTrace.cxx
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+#include <unistd.h>
+
+#include "MFTTestwf/ClusterTrace.h"
+
+#include "FairLogger.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+ClusterTrace::~ClusterTrace()
+{
+  // the closing bracket is optional in the JSON array format, a trace
+  // cut by a crash can still be loaded
+  if (mFile) {
+    *mFile << "\n]\n";
+  }
+}
+
+void ClusterTrace::setNChips(int n)
+{
+  mChipsTF.assign(n, Counts{});
+  mChipsRun.assign(n, Counts{});
+}
+
+bool ClusterTrace::open(const std::string& name, const std::string& process, float minChipUs)
+{
+  mMinChipNs = uint64_t(std::max(0.f, minChipUs) * 1000.f);
+  mOrigin = Clock::now();
+  mPid = ::getpid();
+  if (name.empty()) {
+    return true;
+  }
+  mBuffer.resize(1 << 20);
+  mFile = std::make_unique<std::ofstream>();
+  mFile->rdbuf()->pubsetbuf(mBuffer.data(), mBuffer.size());
+  mFile->open(name);
+  if (!mFile->good()) {
+    mFile.reset();
+    return false;
+  }
+  *mFile << std::fixed << std::setprecision(3) << '[';
+  writeMetadata("process_name", 0, process);
+  writeMetadata("thread_name", 0, "timeframes");
+  writeMetadata("thread_name", 1, "RO frames");
+  writeMetadata("thread_name", 2, "chips");
+  return true;
+}
+
+void ClusterTrace::beginTimeframe(uint32_t tfID)
+{
+  mTFID = tfID;
+  std::fill(mChipsTF.begin(), mChipsTF.end(), Counts{});
+  mROFsTF.clear();
+  mEventsTF.clear();
+  mTimesTF.fill(0);
+  mMaxNsTF = 0;
+}
+
+void ClusterTrace::accountChip(uint16_t chip, uint32_t rof, uint32_t nDigits, uint32_t nClusters,
+                               Clock::time_point start, Clock::time_point end)
+{
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  if (chip >= mChipsTF.size()) {
+    mChipsTF.resize(chip + 1);
+    mChipsRun.resize(chip + 1);
+  }
+  Counts counts;
+  counts.ns = ns;
+  counts.calls = 1;
+  counts.digits = nDigits;
+  counts.clusters = nClusters;
+  mChipsTF[chip].add(counts);
+
+  if (mROFsTF.empty()) {
+    mStartTF = start;
+  }
+  if (mROFsTF.empty() || mROFsTF.back().rof != rof) {
+    mROFsTF.emplace_back();
+    mROFsTF.back().rof = rof;
+    mROFsTF.back().start = start;
+  }
+  mROFsTF.back().add(counts);
+  mROFsTF.back().end = end;
+  mEndTF = end;
+
+  mTimesTF[getTimeBin(ns)]++;
+  mMaxNsTF = std::max(mMaxNsTF, ns);
+  if (mFile && ns >= mMinChipNs) {
+    mEventsTF.push_back(ChipEvent{ chip, rof, nDigits, nClusters, start, ns });
+  }
+}
+
+void ClusterTrace::endTimeframe()
+{
+  for (size_t i = 0; i < mChipsTF.size(); i++) {
+    mChipsRun[i].add(mChipsTF[i]);
+  }
+  for (int b = 0; b < NTimeBins; b++) {
+    mTimesRun[b] += mTimesTF[b];
+  }
+  mNTFs++;
+
+  if (!mFile || mROFsTF.empty()) {
+    return;
+  }
+  Counts total;
+  for (const auto& r : mROFsTF) {
+    total.add(r);
+  }
+  writeEvent("TF " + std::to_string(mTFID), 0, mStartTF,
+             std::chrono::duration_cast<std::chrono::nanoseconds>(mEndTF - mStartTF).count(),
+             "\"tf\":" + std::to_string(mTFID) + ",\"chips\":" + std::to_string(total.calls) +
+               ",\"rofs\":" + std::to_string(mROFsTF.size()) + ",\"digits\":" + std::to_string(total.digits) +
+               ",\"clusters\":" + std::to_string(total.clusters));
+  for (const auto& r : mROFsTF) {
+    writeEvent("ROF " + std::to_string(r.rof), 1, r.start,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(r.end - r.start).count(),
+               "\"tf\":" + std::to_string(mTFID) + ",\"chips\":" + std::to_string(r.calls) +
+                 ",\"digits\":" + std::to_string(r.digits) + ",\"clusters\":" + std::to_string(r.clusters));
+  }
+  for (const auto& e : mEventsTF) {
+    writeEvent("chip " + std::to_string(e.chip), 2, e.start, e.ns,
+               "\"rof\":" + std::to_string(e.rof) + ",\"digits\":" + std::to_string(e.digits) +
+                 ",\"clusters\":" + std::to_string(e.clusters));
+  }
+  mFile->flush();
+}
+
+void ClusterTrace::print(const std::string& device) const
+{
+  if (!mEnabled) {
+    return;
+  }
+  Counts total;
+  for (const auto& r : mROFsTF) {
+    total.add(r);
+  }
+  LOG(INFO) << device << " traced " << total.calls << " chips in " << mROFsTF.size() << " RO frames, "
+            << total.digits << " digits, " << total.clusters << " clusters, in " << 1.e-6 * total.ns
+            << " ms; chip time p50 < " << 1.e-3 * getQuantile(mTimesTF, 0.5) << " us, p99 < "
+            << 1.e-3 * getQuantile(mTimesTF, 0.99) << " us, max " << 1.e-3 * mMaxNsTF << " us";
+
+  auto printTop = [this, &device](const char* what, const std::vector<Counts>& counts, auto id, double scale) {
+    std::vector<size_t> order(counts.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto nTop = std::min(order.size(), size_t(std::max(mNTop, 0)));
+    std::partial_sort(order.begin(), order.begin() + nTop, order.end(),
+                      [&counts](size_t a, size_t b) { return counts[a].ns > counts[b].ns; });
+    for (size_t i = 0; i < nTop && counts[order[i]].ns; i++) {
+      const auto& c = counts[order[i]];
+      LOG(INFO) << device << "   " << what << ' ' << id(order[i]) << ": " << scale * 1.e-3 * c.ns << " us, "
+                << scale * c.digits << " digits, " << scale * c.clusters << " clusters";
+    }
+  };
+  printTop("hot chip", mChipsTF, [](size_t i) { return i; }, 1.);
+  std::vector<Counts> rofs(mROFsTF.begin(), mROFsTF.end());
+  printTop("hot RO frame", rofs, [this](size_t i) { return mROFsTF[i].rof; }, 1.);
+  if (mNTFs > 1) {
+    LOG(INFO) << device << " over " << mNTFs << " timeframes: chip time p99 < "
+              << 1.e-3 * getQuantile(mTimesRun, 0.99) << " us, hottest chips per timeframe:";
+    printTop("hot chip", mChipsRun, [](size_t i) { return i; }, 1. / mNTFs);
+  }
+}
+
+int ClusterTrace::getTimeBin(uint64_t ns)
+{
+  int bin = 0;
+  while (ns >>= 1) {
+    bin++;
+  }
+  return std::min(bin, NTimeBins - 1);
+}
+
+uint64_t ClusterTrace::getQuantile(const TimeHisto& h, double q)
+{
+  // upper edge of the bin reaching the quantile
+  uint64_t total = std::accumulate(h.begin(), h.end(), uint64_t(0)), sum = 0;
+  if (!total) {
+    return 0;
+  }
+  for (int b = 0; b < NTimeBins; b++) {
+    sum += h[b];
+    if (sum >= q * total) {
+      return uint64_t(1) << (b + 1);
+    }
+  }
+  return uint64_t(1) << NTimeBins;
+}
+
+double ClusterTrace::getMicroseconds(Clock::time_point t) const
+{
+  return std::chrono::duration<double, std::micro>(t - mOrigin).count();
+}
+
+void ClusterTrace::writeSeparator()
+{
+  if (!mFirstEvent) {
+    *mFile << ',';
+  }
+  *mFile << '\n';
+  mFirstEvent = false;
+}
+
+void ClusterTrace::writeMetadata(const std::string& name, int tid, const std::string& value)
+{
+  writeSeparator();
+  *mFile << "{\"name\":\"" << name << "\",\"ph\":\"M\",\"pid\":" << mPid << ",\"tid\":" << tid
+         << ",\"args\":{\"name\":\"" << value << "\"}}";
+}
+
+void ClusterTrace::writeEvent(const std::string& name, int tid, Clock::time_point start, uint64_t ns,
+                              const std::string& args)
+{
+  writeSeparator();
+  *mFile << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":" << mPid << ",\"tid\":" << tid
+         << ",\"ts\":" << getMicroseconds(start) << ",\"dur\":" << 1.e-3 * ns << ",\"args\":{" << args << "}}";
+}
+
+} // namespace MFT
+} // namespace o2
@@ -0,0 +1,208 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ClusterTrace.h
+
+#ifndef O2_MFT_CLUSTERTRACE_H_
+#define O2_MFT_CLUSTERTRACE_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ITSMFTReconstruction/PixelReader.h"
+#include "ITSMFTReconstruction/PixelData.h"
+#include "DataFormatsITSMFT/CompCluster.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// time taken by the cluster finder per chip and per RO frame, with the
+/// numbers of digits and clusters; the accumulators of a timeframe are
+/// filled by the thread running the cluster finder only, without locks,
+/// and merged into the totals of the run at the end of the timeframe.
+/// The per-timeframe histograms and vectors are plain members: this relies
+/// on Clusterer::process pulling the chips from the pixel reader on the
+/// calling thread, one chip after the other; a multithreaded cluster finder
+/// would need one set of accumulators per thread, merged at endTimeframe
+class ClusterTrace
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr int NTimeBins = 32; ///< log2 bins of the chip time, in ns
+
+  ClusterTrace() = default;
+  ~ClusterTrace();
+  ClusterTrace(const ClusterTrace&) = delete;
+  ClusterTrace& operator=(const ClusterTrace&) = delete;
+
+  void setEnabled(bool v) { mEnabled = v; }
+  bool isEnabled() const { return mEnabled; }
+  void setNChips(int n);
+  /// number of hottest chips and RO frames printed per timeframe
+  void setNTop(int n) { mNTop = n; }
+
+  /// write the timed RO frames, and the chips taking at least minChipUs
+  /// microseconds, as events of the Chrome trace format (JSON array);
+  /// false if the file cannot be opened
+  bool open(const std::string& name, const std::string& process, float minChipUs);
+
+  void beginTimeframe(uint32_t tfID);
+  /// account one chip of a RO frame processed between start and end
+  void accountChip(uint16_t chip, uint32_t rof, uint32_t nDigits, uint32_t nClusters,
+                   Clock::time_point start, Clock::time_point end);
+  void endTimeframe();
+  void print(const std::string& device) const;
+
+ private:
+  struct Counts {
+    uint64_t ns = 0; ///< processing time
+    uint32_t calls = 0;
+    uint32_t digits = 0;
+    uint32_t clusters = 0;
+    void add(const Counts& o)
+    {
+      ns += o.ns;
+      calls += o.calls;
+      digits += o.digits;
+      clusters += o.clusters;
+    }
+  };
+  struct ROFCounts : Counts {
+    uint32_t rof = 0;
+    Clock::time_point start, end;
+  };
+  struct ChipEvent {
+    uint16_t chip = 0;
+    uint32_t rof = 0;
+    uint32_t digits = 0;
+    uint32_t clusters = 0;
+    Clock::time_point start;
+    uint64_t ns = 0;
+  };
+  using TimeHisto = std::array<uint64_t, NTimeBins>;
+
+  static int getTimeBin(uint64_t ns);
+  static uint64_t getQuantile(const TimeHisto& h, double q);
+  double getMicroseconds(Clock::time_point t) const;
+  void writeMetadata(const std::string& name, int tid, const std::string& value);
+  void writeEvent(const std::string& name, int tid, Clock::time_point start, uint64_t ns, const std::string& args);
+  void writeSeparator();
+
+  bool mEnabled = false;
+  int mNTop = 5;
+  uint32_t mTFID = 0;
+
+  // accumulators of the current timeframe
+  std::vector<Counts> mChipsTF;
+  std::vector<ROFCounts> mROFsTF; ///< in the order of processing, the chips come grouped by RO frame
+  std::vector<ChipEvent> mEventsTF;
+  TimeHisto mTimesTF{};
+  uint64_t mMaxNsTF = 0;
+  Clock::time_point mStartTF, mEndTF;
+
+  // totals of the run
+  std::vector<Counts> mChipsRun;
+  TimeHisto mTimesRun{};
+  size_t mNTFs = 0;
+
+  // trace file
+  std::vector<char> mBuffer;
+  std::unique_ptr<std::ofstream> mFile;
+  Clock::time_point mOrigin;
+  uint64_t mMinChipNs = 0;
+  int mPid = 0;
+  bool mFirstEvent = true;
+};
+
+/// PixelReader timing the cluster finder between two calls to
+/// getNextChipData: the interval between the delivery of a chip and the
+/// request of the next one is the time taken to find the clusters of the
+/// chip, which appear at the end of the cluster vector
+class TracingPixelReader : public o2::ITSMFT::PixelReader
+{
+ public:
+  TracingPixelReader(o2::ITSMFT::PixelReader& reader, ClusterTrace& trace,
+                     const std::vector<o2::ITSMFT::CompClusterExt>& clusters)
+    : mReader(reader), mTrace(trace), mClusters(clusters)
+  {
+  }
+  ~TracingPixelReader() override = default;
+
+  const o2::dataformats::MCTruthContainer<o2::MCCompLabel>* getDigitsMCTruth() const override
+  {
+    return mReader.getDigitsMCTruth();
+  }
+  void init() override
+  {
+    mReader.init();
+    mPending = false;
+  }
+  bool getNextChipData(o2::ITSMFT::ChipPixelData& chipData) override
+  {
+    accountPending();
+    bool res = mReader.getNextChipData(chipData);
+    if (res) {
+      setPending(chipData);
+    }
+    return res;
+  }
+  o2::ITSMFT::ChipPixelData* getNextChipData(std::vector<o2::ITSMFT::ChipPixelData>& chipDataVec) override
+  {
+    accountPending();
+    auto* chipData = mReader.getNextChipData(chipDataVec);
+    if (chipData) {
+      setPending(*chipData);
+    }
+    return chipData;
+  }
+  /// account the last chip, if the cluster finder did not ask for another one
+  void flush() { accountPending(); }
+
+ private:
+  void setPending(const o2::ITSMFT::ChipPixelData& chipData)
+  {
+    mChip = chipData.getChipID();
+    mROF = chipData.getROFrame();
+    mNDigits = chipData.getData().size();
+    mNClusters = mClusters.size();
+    mPending = true;
+    mStart = ClusterTrace::Clock::now();
+  }
+  void accountPending()
+  {
+    if (mPending) {
+      auto end = ClusterTrace::Clock::now();
+      mTrace.accountChip(mChip, mROF, mNDigits, mClusters.size() - mNClusters, mStart, end);
+      mPending = false;
+    }
+  }
+
+  o2::ITSMFT::PixelReader& mReader;
+  ClusterTrace& mTrace;
+  const std::vector<o2::ITSMFT::CompClusterExt>& mClusters;
+  bool mPending = false;
+  uint16_t mChip = 0;
+  uint32_t mROF = 0;
+  uint32_t mNDigits = 0;
+  size_t mNClusters = 0;
+  ClusterTrace::Clock::time_point mStart;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_CLUSTERTRACE */
@@ -10,13 +10,17 @@
 
 /// @file   ClusterWriterSpec.cxx
 
+#include <algorithm>
 #include <vector>
+#include <fstream>
 
 #include "TTree.h"
 
 #include "MFTTestwf/ClusterWriterSpec.h"
+#include "MFTTestwf/PackedDigits.h"
 
 #include "Framework/ControlService.h"
+#include "Framework/DataRefUtils.h"
 #include "SimulationDataFormat/MCCompLabel.h"
 #include "SimulationDataFormat/MCTruthContainer.h"
 #include "DataFormatsITSMFT/CompCluster.h"
@@ -30,19 +34,285 @@ namespace o2
 namespace MFT
 {
 
-void ClusterWriter::init(InitContext& ic)
+template <typename Mapping>
+bool ClusterWriter<Mapping>::create(const std::string& filename)
 {
-  auto filename = ic.options().get<std::string>("mft-cluster-outfile");
   mFile = std::make_unique<TFile>(filename.c_str(), "RECREATE");
   if (!mFile->IsOpen()) {
     LOG(ERROR) << "Cannot open the " << filename.c_str() << " file !";
-    mState = 0;
-    return;
+    return false;
+  }
+  mTree = new TTree("o2sim", (std::string("Tree with ") + Traits::Name + " clusters").c_str());
+  mOutFile = filename;
+  return true;
+}
+
+template <typename Mapping>
+bool ClusterWriter<Mapping>::reopen(const Checkpoint& progress)
+{
+  // the committed timeframes are kept, the tree is recovered as of its last
+  // autosave; the timeframes after it are written again
+  mFile = std::make_unique<TFile>(progress.outFile.c_str(), "UPDATE");
+  mTree = mFile->IsOpen() ? (TTree*)mFile->Get("o2sim") : nullptr;
+  if (!mTree || mTree->GetEntries() < progress.nEntries) {
+    LOG(ERROR) << "Cannot resume the " << progress.outFile.c_str() << " file, it has "
+               << (mTree ? mTree->GetEntries() : 0) << " tree entries and " << progress.nEntries
+               << " are committed in " << mCheckpointFile.c_str() << " !";
+    return false;
+  }
+  std::unique_ptr<std::vector<o2::ITSMFT::ROFRecord>> rofs((std::vector<o2::ITSMFT::ROFRecord>*)mFile->GetObjectChecked(
+    getDetectorName<Mapping>("ClusterROF").c_str(), "vector<o2::ITSMFT::ROFRecord>"));
+  std::unique_ptr<std::vector<o2::ITSMFT::MC2ROFRecord>> mc2rofs((std::vector<o2::ITSMFT::MC2ROFRecord>*)mFile->GetObjectChecked(
+    getDetectorName<Mapping>("ClusterMC2ROF").c_str(), "vector<o2::ITSMFT::MC2ROFRecord>"));
+  if (rofs) {
+    mROFs.swap(*rofs);
+  }
+  if (mc2rofs) {
+    mMC2ROFs.swap(*mc2rofs);
+  }
+  // a crash between the autosave and the manifest leaves more entries than committed
+  mFirstTF = mTree->GetEntries();
+  mGlobal = mTree->GetBranch(getDetectorName<Mapping>("ClusterGloX").c_str()) != nullptr;
+  // the branches are set up for one mode at the first entry, the other one
+  // would write to a missing ClusterEnc branch or leave it unfilled
+  bool encoded = mTree->GetBranch(getDetectorName<Mapping>("ClusterEnc").c_str()) != nullptr;
+  if (mTree->GetNbranches() > 0 && encoded != mEncode) {
+    LOG(ERROR) << "Cannot resume the " << progress.outFile.c_str() << " file, its compact clusters are "
+               << (encoded ? "" : "not ") << "encoded, run with" << (encoded ? "" : "out") << " --"
+               << getDetectorOption<Mapping>("-cluster-encoding").c_str() << " !";
+    return false;
+  }
+  mOutFile = progress.outFile;
+  LOG(INFO) << Traits::Name << "ClusterWriter resumes the " << mOutFile.c_str() << " file after "
+            << progress.nWritten << "/" << progress.nTFs << " timeframes";
+  return true;
+}
+
+template <typename Mapping>
+void ClusterWriter<Mapping>::init(InitContext& ic)
+{
+  auto filename = ic.options().get<std::string>(getDetectorOption<Mapping>("-cluster-outfile"));
+  mCheckpointFile = ic.options().get<std::string>(getDetectorOption<Mapping>("-checkpoint-file"));
+  mCheckpointInterval = std::max(0, ic.options().get<int>(getDetectorOption<Mapping>("-checkpoint-interval")));
+  bool resume = ic.options().get<bool>(getDetectorOption<Mapping>("-resume"));
+  mCheckpoint = mCheckpointInterval > 0 || resume;
+  mEncode = ic.options().get<bool>(getDetectorOption<Mapping>("-cluster-encoding"));
+
+  Checkpoint progress;
+  if (resume && progress.read(mCheckpointFile)) {
+    if (progress.isComplete()) {
+      LOG(INFO) << Traits::Name << "ClusterWriter: all the timeframes are already written in " << progress.outFile.c_str();
+      mState = 2;
+      return;
+    }
+    if (!reopen(progress)) {
+      mState = 0;
+      return;
+    }
+  } else {
+    if (resume) {
+      LOG(INFO) << Traits::Name << "ClusterWriter: no progress manifest " << mCheckpointFile.c_str()
+                << ", the clusters are written from the first timeframe";
+    }
+    if (!create(filename)) {
+      mState = 0;
+      return;
+    }
+  }
+  mChannelStats.setEnabled(ic.options().get<bool>(getDetectorOption<Mapping>("-channel-stats")));
+  if (ic.options().get<int>(getDetectorOption<Mapping>("-max-inflight-tfs")) > 0) {
+    auto id = FlowControl::getId(ic.options().get<std::string>(getDetectorOption<Mapping>("-flow-control-id")),
+                                 getDetectorOption<Mapping>("-flow-control"));
+    if (!mFlowControl.open(id, false)) {
+      mState = 0;
+      return;
+    }
+  }
+  if (mEncode) {
+    // the pattern IDs are coded with the frequencies of the clusterer dictionary
+    auto dictname = ic.options().get<std::string>(getDetectorOption<Mapping>("-dictionary-file"));
+    if (std::ifstream(dictname.c_str()).good()) {
+      mDictionary.ReadBinaryFile(dictname);
+      if (mCoder.setDictionary(&mDictionary)) {
+        LOG(INFO) << Traits::Name << "ClusterWriter encodes the clusters with the dictionary " << dictname.c_str();
+      }
+    } else {
+      mCoder.setDictionary(nullptr);
+      LOG(WARNING) << Traits::Name << "ClusterWriter encodes the clusters without a dictionary";
+    }
   }
   mState = 1;
 }
 
-void ClusterWriter::run(ProcessingContext& pc)
+template <typename Mapping>
+void ClusterWriter<Mapping>::write(std::vector<o2::ITSMFT::CompClusterExt>& compClusters,
+                                   std::vector<o2::ITSMFT::Cluster>& clusters,
+                                   const o2::dataformats::MCTruthContainer<o2::MCCompLabel>* labels,
+                                   const std::vector<o2::ITSMFT::ROFRecord>& rofs,
+                                   const std::vector<o2::ITSMFT::MC2ROFRecord>& mc2rofs,
+                                   const ClusterCoordinates& global,
+                                   const TimeframeInfo& info)
+{
+  LOG(INFO) << Traits::Name << "ClusterWriter pulled " << clusters.size() << " clusters, "
+            << labels->getIndexedSize() << " MC label objects, in "
+            << rofs.size() << " RO frames and "
+            << mc2rofs.size() << " MC events, timeframe "
+            << info.tfID << "/" << info.nTFs;
+
+  if (info.tfID < mFirstTF) {
+    LOG(INFO) << Traits::Name << "ClusterWriter skips the timeframe " << info.tfID << ", already in " << mOutFile.c_str();
+    mFlowControl.acknowledge(info.tfID);
+    if (info.isLast()) {
+      finish(info);
+    }
+    return;
+  }
+
+  mCompClustersPtr = &compClusters;
+  mClustersPtr = &clusters;
+  mLabelsPtr = labels;
+  if (mTree->GetNbranches() == 0) {
+    // the clusterer tells whether it computes the global positions
+    mGlobal = info.hasGlobal;
+  }
+  bool hasGlobal = mGlobal && global.x.size() == clusters.size() && global.y.size() == clusters.size() &&
+                   global.z.size() == clusters.size();
+  if (mGlobal && !hasGlobal) {
+    LOG(ERROR) << Traits::Name << "ClusterWriter got " << global.x.size() << " global positions for "
+               << clusters.size() << " clusters, none is written for the timeframe " << info.tfID << " !";
+  }
+  if (hasGlobal) {
+    mGlobalXYZ = global;
+  } else {
+    mGlobalXYZ.clear();
+  }
+  if (mEncode) {
+    mClusterROFs.resize(clusters.size());
+    for (size_t i = 0; i < clusters.size(); i++) {
+      mClusterROFs[i] = clusters[i].getROFrame();
+    }
+    if (!mCoder.encode(compClusters, mClusterROFs, mEncoded, mOrder)) {
+      LOG(ERROR) << Traits::Name << "ClusterWriter cannot encode the clusters of the timeframe " << info.tfID
+                 << ", their compact clusters are written as such";
+    } else if (!mOrder.empty()) {
+      // the full clusters and the labels follow the encoded order
+      mSortedClusters.clear();
+      for (auto i : mOrder) {
+        mSortedClusters.push_back(clusters[i]);
+      }
+      PackedDigits::reorderLabels(*labels, mOrder, mSortedLabels);
+      for (size_t i = 0; i < mOrder.size() && hasGlobal; i++) {
+        mGlobalXYZ.x[i] = global.x[mOrder[i]];
+        mGlobalXYZ.y[i] = global.y[mOrder[i]];
+        mGlobalXYZ.z[i] = global.z[mOrder[i]];
+      }
+      mClustersPtr = &mSortedClusters;
+      mLabelsPtr = &mSortedLabels;
+    }
+    if (!mEncoded.empty()) {
+      // the ClusterComp branch only holds the timeframes that could not be encoded
+      mCompClustersPtr = &mNoCompClusters;
+      LOG(INFO) << Traits::Name << "ClusterWriter encoded " << compClusters.size() * sizeof(o2::ITSMFT::CompClusterExt)
+                << " bytes of compact clusters in " << mEncoded.size() << " bytes";
+    }
+  }
+  auto compName = getDetectorName<Mapping>("ClusterComp");
+  auto encName = getDetectorName<Mapping>("ClusterEnc");
+  auto clusName = getDetectorName<Mapping>("Cluster");
+  auto labelName = getDetectorName<Mapping>("ClusterMCTruth");
+  if (mTree->GetNbranches() == 0) {
+    if (mEncode) {
+      mTree->Branch(encName.c_str(), &mEncodedPtr);
+    }
+    mTree->Branch(compName.c_str(), &mCompClustersPtr);
+    mTree->Branch(clusName.c_str(), &mClustersPtr);
+    mTree->Branch(labelName.c_str(), &mLabelsPtr);
+    if (mGlobal) {
+      mTree->Branch(getDetectorName<Mapping>("ClusterGloX").c_str(), &mGlobalPtr[0]);
+      mTree->Branch(getDetectorName<Mapping>("ClusterGloY").c_str(), &mGlobalPtr[1]);
+      mTree->Branch(getDetectorName<Mapping>("ClusterGloZ").c_str(), &mGlobalPtr[2]);
+    }
+  } else {
+    if (mEncode) {
+      mTree->SetBranchAddress(encName.c_str(), &mEncodedPtr);
+    }
+    mTree->SetBranchAddress(compName.c_str(), &mCompClustersPtr);
+    mTree->SetBranchAddress(clusName.c_str(), &mClustersPtr);
+    mTree->SetBranchAddress(labelName.c_str(), &mLabelsPtr);
+    if (mGlobal) {
+      mTree->SetBranchAddress(getDetectorName<Mapping>("ClusterGloX").c_str(), &mGlobalPtr[0]);
+      mTree->SetBranchAddress(getDetectorName<Mapping>("ClusterGloY").c_str(), &mGlobalPtr[1]);
+      mTree->SetBranchAddress(getDetectorName<Mapping>("ClusterGloZ").c_str(), &mGlobalPtr[2]);
+    }
+  }
+  mTree->Fill();
+  mFlowControl.acknowledge(info.tfID);
+  mROFs.insert(mROFs.end(), rofs.begin(), rofs.end());
+  mMC2ROFs.insert(mMC2ROFs.end(), mc2rofs.begin(), mc2rofs.end());
+
+  if (!info.isLast()) {
+    if (mCheckpointInterval > 0 && (info.tfID + 1) % mCheckpointInterval == 0) {
+      commit(info);
+    }
+    return;
+  }
+  finish(info);
+}
+
+template <typename Mapping>
+void ClusterWriter<Mapping>::finish(const TimeframeInfo& info)
+{
+  mFile->cd();
+  writeROFRecords();
+  mTree->Write(nullptr, TObject::kWriteDelete);
+  mFile->Close();
+  mTree = nullptr;
+  if (mCheckpoint) {
+    writeProgress(info, info.nTFs);
+  }
+  mFlowControl.unlink();
+  mState = 2;
+}
+
+template <typename Mapping>
+void ClusterWriter<Mapping>::writeROFRecords()
+{
+  // the previous cycles of a checkpoint are deleted once the new ones are written
+  mFile->WriteObjectAny(&mROFs, "std::vector<o2::ITSMFT::ROFRecord>", getDetectorName<Mapping>("ClusterROF").c_str(), "WriteDelete");
+  mFile->WriteObjectAny(&mMC2ROFs, "std::vector<o2::ITSMFT::MC2ROFRecord>", getDetectorName<Mapping>("ClusterMC2ROF").c_str(), "WriteDelete");
+}
+
+template <typename Mapping>
+void ClusterWriter<Mapping>::commit(const TimeframeInfo& info)
+{
+  // the baskets, the RO frame records and the tree header are on disk before
+  // the manifest points past them: after a crash, the file reopened holds at
+  // least the timeframes the manifest says are committed
+  mFile->cd();
+  writeROFRecords();
+  mTree->AutoSave("SaveSelf");
+  mFile->Flush();
+  writeProgress(info, info.tfID + 1);
+}
+
+template <typename Mapping>
+void ClusterWriter<Mapping>::writeProgress(const TimeframeInfo& info, uint32_t nWritten)
+{
+  Checkpoint progress;
+  progress.outFile = mOutFile;
+  progress.nTFs = info.nTFs;
+  progress.nWritten = nWritten;
+  progress.nEntries = mTree ? mTree->GetEntries() : nWritten;
+  progress.nextROF = info.nextROF;
+  progress.nReaders = info.nReaders;
+  if (progress.write(mCheckpointFile)) {
+    LOG(INFO) << Traits::Name << "ClusterWriter committed " << nWritten << "/" << info.nTFs << " timeframes to "
+              << mOutFile.c_str();
+  }
+}
+
+template <typename Mapping>
+void ClusterWriter<Mapping>::run(ProcessingContext& pc)
 {
   if (mState != 1)
     return;
@@ -50,46 +320,58 @@ void ClusterWriter::run(ProcessingContext& pc)
   auto compClusters = pc.inputs().get<const std::vector<o2::ITSMFT::CompClusterExt>>("compClusters");
   auto clusters = pc.inputs().get<const std::vector<o2::ITSMFT::Cluster>>("clusters");
   auto labels = pc.inputs().get<const o2::dataformats::MCTruthContainer<o2::MCCompLabel>*>("labels");
-  auto plabels = labels.get();
   auto rofs = pc.inputs().get<const std::vector<o2::ITSMFT::ROFRecord>>("ROframes");
   auto mc2rofs = pc.inputs().get<const std::vector<o2::ITSMFT::MC2ROFRecord>>("MC2ROframes");
+  auto info = pc.inputs().get<TimeframeInfo>("tfinfo");
+  auto global = DataRefUtils::as<const float>(pc.inputs().get("global"));
+  size_t n = global.size() / 3;
+  mInputGlobal.x.assign(global.begin(), global.begin() + n);
+  mInputGlobal.y.assign(global.begin() + n, global.begin() + 2 * n);
+  mInputGlobal.z.assign(global.begin() + 2 * n, global.end());
 
-  LOG(INFO) << "MFTClusterWriter pulled " << clusters.size() << " clusters, "
-            << labels->getIndexedSize() << " MC label objects, in "
-            << rofs.size() << " RO frames and "
-            << mc2rofs.size() << " MC events";
-
-  mFile->WriteObjectAny(&rofs, "std::vector<o2::ITSMFT::ROFRecord>", "MFTClusterROF");
-  mFile->WriteObjectAny(&mc2rofs, "std::vector<o2::ITSMFT::MC2ROFRecord>", "MFTClusterMC2ROF");
+  mChannelStats.account(pc.inputs());
 
-  TTree tree("o2sim", "Tree with MFT clusters");
-  tree.Branch("MFTClusterComp", &compClusters);
-  tree.Branch("MFTCluster", &clusters);
-  tree.Branch("MFTClusterMCTruth", &plabels);
-  tree.Fill();
-  tree.Write();
-  mFile->Close();
+  write(compClusters, clusters, labels.get(), rofs, mc2rofs, mInputGlobal, info);
 
-  mState = 2;
-  pc.services().get<ControlService>().readyToQuit(true);
+  if (isDone()) {
+    mChannelStats.print(getDetectorName<Mapping>("ClusterWriter"));
+    pc.services().get<ControlService>().readyToQuit(true);
+  }
 }
 
+template <typename Mapping>
 DataProcessorSpec getClusterWriterSpec()
 {
+  constexpr auto origin = DetectorTraits<Mapping>::Origin;
   return DataProcessorSpec{
-    "mft-cluster-writer",
+    getDetectorOption<Mapping>("-cluster-writer"),
     Inputs{
-      InputSpec{ "compClusters", "MFT", "COMPCLUSTERS", 0, Lifetime::Timeframe },
-      InputSpec{ "clusters", "MFT", "CLUSTERS", 0, Lifetime::Timeframe },
-      InputSpec{ "labels", "MFT", "CLUSTERSMCTR", 0, Lifetime::Timeframe },
-      InputSpec{ "ROframes", "MFT", "MFTClusterROF", 0, Lifetime::Timeframe },
-      InputSpec{ "MC2ROframes", "MFT", "MFTClusterMC2ROF", 0, Lifetime::Timeframe } },
+      InputSpec{ "compClusters", origin, "COMPCLUSTERS", 0, Lifetime::Timeframe },
+      InputSpec{ "clusters", origin, "CLUSTERS", 0, Lifetime::Timeframe },
+      InputSpec{ "labels", origin, "CLUSTERSMCTR", 0, Lifetime::Timeframe },
+      InputSpec{ "ROframes", origin, getDetectorDescription<Mapping>("ClusterROF"), 0, Lifetime::Timeframe },
+      InputSpec{ "MC2ROframes", origin, getDetectorDescription<Mapping>("ClusterMC2ROF"), 0, Lifetime::Timeframe },
+      InputSpec{ "tfinfo", origin, getDetectorDescription<Mapping>("ClusterTFInfo"), 0, Lifetime::Timeframe },
+      InputSpec{ "global", origin, "CLUSTERSGLO", 0, Lifetime::Timeframe } },
     Outputs{},
-    AlgorithmSpec{ adaptFromTask<ClusterWriter>() },
+    AlgorithmSpec{ adaptFromTask<ClusterWriter<Mapping>>() },
     Options{
-      { "mft-cluster-outfile", VariantType::String, "mftclusters.root", { "Name of the output file" } } }
+      { getDetectorOption<Mapping>("-cluster-outfile"), VariantType::String, getDetectorOption<Mapping>("clusters.root").c_str(), { "Name of the output file" } },
+      { getDetectorOption<Mapping>("-cluster-encoding"), VariantType::Bool, false, { "Write the compact clusters entropy-coded (ClusterEnc branch, ClusterComp only for the timeframes not encoded)" } },
+      { getDetectorOption<Mapping>("-dictionary-file"), VariantType::String, "complete_dictionary.bin", { "Name of the cluster-topology dictionary file" } },
+      { getDetectorOption<Mapping>("-channel-stats"), VariantType::Bool, false, { "Report the bytes received per input route" } },
+      { getDetectorOption<Mapping>("-max-inflight-tfs"), VariantType::Int, 0, { "Maximum number of timeframes sent and not yet written, 0 for no limit" } },
+      { getDetectorOption<Mapping>("-flow-control-id"), VariantType::String, "", { "Name of the flow control block shared by the readers and the cluster writer, by default <detector>-flow-control-<driver pid>" } },
+      { getDetectorOption<Mapping>("-checkpoint-interval"), VariantType::Int, 0, { "Commit the output file and the progress manifest every N timeframes, 0 to write them only at the end" } },
+      { getDetectorOption<Mapping>("-checkpoint-file"), VariantType::String, getDetectorOption<Mapping>("clusters.progress").c_str(), { "Progress manifest of the cluster production" } },
+      { getDetectorOption<Mapping>("-resume"), VariantType::Bool, false, { "Resume the production after the timeframes committed in the progress manifest" } } }
   };
 }
 
+template class ClusterWriter<o2::ITSMFT::ChipMappingMFT>;
+template class ClusterWriter<o2::ITSMFT::ChipMappingITS>;
+template DataProcessorSpec getClusterWriterSpec<o2::ITSMFT::ChipMappingMFT>();
+template DataProcessorSpec getClusterWriterSpec<o2::ITSMFT::ChipMappingITS>();
+
 } // namespace MFT
 } // namespace o2
@@ -14,10 +14,18 @@
 #define O2_MFT_CLUSTERWRITER_H_
 
 #include "TFile.h"
+#include "TTree.h"
 
 #include "Framework/DataProcessorSpec.h"
 #include "Framework/Task.h"
 
+#include "MFTTestwf/TimeframeData.h"
+#include "MFTTestwf/ChannelStats.h"
+#include "MFTTestwf/FlowControl.h"
+#include "MFTTestwf/Checkpoint.h"
+#include "MFTTestwf/ClusterCoder.h"
+#include "MFTTestwf/DetectorTraits.h"
+
 using namespace o2::framework;
 
 namespace o2
@@ -25,20 +33,78 @@ namespace o2
 namespace MFT
 {
 
+/// cluster writer of the detector selected by its chip mapping (ChipMappingMFT, ChipMappingITS)
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
 class ClusterWriter : public Task
 {
  public:
+  using Traits = DetectorTraits<Mapping>;
+
   ClusterWriter() = default;
   ~ClusterWriter() = default;
   void init(InitContext& ic) final;
   void run(ProcessingContext& pc) final;
 
+  /// write the clusters of a timeframe as one tree entry and acknowledge it
+  /// to the readers, the output file is closed after the last timeframe of the run;
+  /// with checkpoints, the output file is committed every chunk of timeframes
+  /// and the progress manifest updated;
+  /// with the encoding, the compact clusters are entropy-coded and the full
+  /// clusters and labels follow the encoded order, the compact clusters of a
+  /// timeframe that cannot be encoded are written as such
+  void write(std::vector<o2::ITSMFT::CompClusterExt>& compClusters,
+             std::vector<o2::ITSMFT::Cluster>& clusters,
+             const o2::dataformats::MCTruthContainer<o2::MCCompLabel>* labels,
+             const std::vector<o2::ITSMFT::ROFRecord>& rofs,
+             const std::vector<o2::ITSMFT::MC2ROFRecord>& mc2rofs,
+             const ClusterCoordinates& global,
+             const TimeframeInfo& info);
+  void write(ClustersTF& tf) { write(tf.compClusters, tf.clusters, &tf.labels, tf.rofs, tf.mc2rofs, tf.global, tf.info); }
+  bool isDone() const { return mState == 2; }
+  /// false until init succeeded
+  bool isReady() const { return mState != 0; }
+
  private:
+  bool create(const std::string& filename);
+  bool reopen(const Checkpoint& progress);
+  void writeROFRecords();
+  void commit(const TimeframeInfo& info);
+  void finish(const TimeframeInfo& info);
+  void writeProgress(const TimeframeInfo& info, uint32_t nWritten);
+
   int mState = 0;
+  std::string mOutFile;
   std::unique_ptr<TFile> mFile = nullptr;
+  TTree* mTree = nullptr; ///< owned by the output file
+  std::vector<o2::ITSMFT::CompClusterExt>* mCompClustersPtr = nullptr;
+  std::vector<o2::ITSMFT::Cluster>* mClustersPtr = nullptr;
+  const o2::dataformats::MCTruthContainer<o2::MCCompLabel>* mLabelsPtr = nullptr;
+  std::vector<o2::ITSMFT::ROFRecord> mROFs;       ///< RO frames of all the timeframes
+  std::vector<o2::ITSMFT::MC2ROFRecord> mMC2ROFs; ///< MC events of all the timeframes
+  bool mEncode = false;
+  o2::ITSMFT::TopologyDictionary mDictionary;
+  ClusterCoder mCoder;
+  std::vector<uint8_t> mEncoded;
+  std::vector<uint8_t>* mEncodedPtr = &mEncoded;
+  std::vector<uint32_t> mClusterROFs;
+  std::vector<int> mOrder;
+  std::vector<o2::ITSMFT::CompClusterExt> mNoCompClusters; ///< ClusterComp entry of the encoded timeframes
+  std::vector<o2::ITSMFT::Cluster> mSortedClusters;
+  o2::dataformats::MCTruthContainer<o2::MCCompLabel> mSortedLabels;
+  bool mGlobal = false; ///< the tree has the branches of the global positions, if the clusterer computes them
+  ClusterCoordinates mInputGlobal; ///< global positions received from the clusterer
+  ClusterCoordinates mGlobalXYZ;   ///< global positions written, in the order of the clusters
+  std::vector<float>* mGlobalPtr[3] = { &mGlobalXYZ.x, &mGlobalXYZ.y, &mGlobalXYZ.z };
+  ChannelStats mChannelStats;
+  FlowControl mFlowControl;
+  bool mCheckpoint = false;         ///< keep the progress manifest
+  uint32_t mCheckpointInterval = 0; ///< commit the output every so many timeframes, 0 only at the end
+  std::string mCheckpointFile;
+  uint32_t mFirstTF = 0; ///< timeframes already in the output file reopened to resume
 };
 
-/// create a processor spec and write MFT clusters in a root file
+/// create a processor spec and write MFT (or ITS) clusters in a root file
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
 framework::DataProcessorSpec getClusterWriterSpec();
 
 } // namespace MFT
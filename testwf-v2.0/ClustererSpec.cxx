@@ -11,16 +11,16 @@
 /// @file   ClustererSpec.cxx
 
 #include <vector>
+#include <algorithm>
 
 #include "MFTTestwf/ClustererSpec.h"
-
-#include "MFTBase/GeometryTGeo.h"
+#include "MFTTestwf/PackedDigits.h"
+#include "MFTTestwf/ChipTransform.h"
 
 #include "ITSMFTBase/Digit.h"
-#include "ITSMFTReconstruction/ChipMappingMFT.h"
-#include "ITSMFTReconstruction/DigitPixelReader.h"
 
 #include "Framework/ControlService.h"
+#include "Framework/DataRefUtils.h"
 #include "SimulationDataFormat/MCCompLabel.h"
 #include "SimulationDataFormat/MCTruthContainer.h"
 #include "DetectorsBase/GeometryManager.h"
@@ -35,97 +35,245 @@ namespace o2
 namespace MFT
 {
 
-void ClustererDPL::init(InitContext& ic)
+template <typename Mapping>
+void ClustererDPL<Mapping>::init(InitContext& ic)
 {
   o2::Base::GeometryManager::loadGeometry(); // for generating full clusters
-  o2::MFT::GeometryTGeo* geom = o2::MFT::GeometryTGeo::Instance();
-  geom->fillMatrixCache(o2::utils::bit2Mask(o2::TransformType::T2L));
+  auto* geom = Traits::Geometry::Instance();
+  mGlobal = ic.options().get<bool>(getDetectorOption<Mapping>("-cluster-global"));
+  if (mGlobal) {
+    geom->fillMatrixCache(o2::utils::bit2Mask(o2::TransformType::T2L, o2::TransformType::T2G));
+  } else {
+    geom->fillMatrixCache(o2::utils::bit2Mask(o2::TransformType::T2L));
+  }
 
   mClusterer = std::make_unique<o2::ITSMFT::Clusterer>();
   mClusterer->setGeometry(geom);
-  //mClusterer->setNChips(o2::ITSMFT::ChipMappingMFT::getNChips()); // FIXME !
-  mClusterer->setNChips(geom->getNumberOfChips());
+  // the chip IDs of the digits follow the mapping, the geometry may describe
+  // fewer chips: the clusterer is sized for the larger of the two
+  if (geom->getNumberOfChips() != Traits::NChips) {
+    LOG(WARNING) << Traits::Name << "Clusterer: the geometry has " << geom->getNumberOfChips()
+                 << " chips, the chip mapping " << Traits::NChips;
+  }
+  mClusterer->setNChips(std::max(int(geom->getNumberOfChips()), Traits::NChips));
 
   //mClusterer->setMaskOverflowPixels(false);
 
-  auto filename = ic.options().get<std::string>("mft-dictionary-file");
+  auto filename = ic.options().get<std::string>(getDetectorOption<Mapping>("-dictionary-file"));
   mFile = std::make_unique<std::ifstream>(filename.c_str(), std::ios::in | std::ios::binary);
   if (mFile->good()) {
     mClusterer->loadDictionary(filename);
-    LOG(INFO) << "MFTClusterer running with a provided dictionary: " << filename.c_str();
+    LOG(INFO) << Traits::Name << "Clusterer running with a provided dictionary: " << filename.c_str();
     mState = 1;
   } else {
-    LOG(INFO) << "MFTClusterer running without a dictionary";
+    LOG(INFO) << Traits::Name << "Clusterer running without a dictionary";
     mState = 1;
     //LOG(WARNING) << "Cannot open the " << filename.c_str() << " file !";
     //mState = 0;
   }
 
   mClusterer->print();
+
+  // the MC labels keep their capacity as well when cleared, but their
+  // storage is not exposed and cannot be accounted
+  mBuffers.add(mTF.compClusters, "compClusters");
+  mBuffers.add(mTF.clusters, "clusters");
+  mBuffers.add(mTF.rofs, "ROframes");
+  mBuffers.add(mTF.mc2rofs, "MC2ROframes");
+  mBuffers.add(mTF.global.x, "globalX");
+  mBuffers.add(mTF.global.y, "globalY");
+  mBuffers.add(mTF.global.z, "globalZ");
+  mBuffers.setTrimPolicy(ic.options().get<float>(getDetectorOption<Mapping>("-buffer-trim-factor")),
+                         ic.options().get<int>(getDetectorOption<Mapping>("-buffer-trim-window")));
+
+  mChannelStats.setEnabled(ic.options().get<bool>(getDetectorOption<Mapping>("-channel-stats")));
+
+  mTrace.setEnabled(ic.options().get<bool>(getDetectorOption<Mapping>("-cluster-trace")));
+  if (mTrace.isEnabled()) {
+    mTrace.setNChips(Traits::NChips);
+    mTrace.setNTop(ic.options().get<int>(getDetectorOption<Mapping>("-cluster-trace-top")));
+    auto traceFile = ic.options().get<std::string>(getDetectorOption<Mapping>("-cluster-trace-file"));
+    if (!mTrace.open(traceFile, getDetectorOption<Mapping>("-clusterer"),
+                     ic.options().get<float>(getDetectorOption<Mapping>("-cluster-trace-min-chip")))) {
+      LOG(WARNING) << "Cannot open the " << traceFile << " trace file, the chips are timed without it";
+    }
+  }
 }
 
-void ClustererDPL::run(ProcessingContext& pc)
+template <typename Mapping>
+void ClustererDPL<Mapping>::run(ProcessingContext& pc)
 {
-  if (mState > 1)
+  if (mState != 1)
     return;
 
-  auto digits = pc.inputs().get<const std::vector<o2::ITSMFT::Digit>>("digits");
+  process(pc, mTF);
+  send(pc, mTF);
+}
+
+template <typename Mapping>
+void ClustererDPL<Mapping>::process(ProcessingContext& pc, ClustersTF& tf)
+{
   auto labels = pc.inputs().get<const o2::dataformats::MCTruthContainer<o2::MCCompLabel>*>("labels");
   auto rofs = pc.inputs().get<const std::vector<o2::ITSMFT::ROFRecord>>("ROframes");
   auto mc2rofs = pc.inputs().get<const std::vector<o2::ITSMFT::MC2ROFRecord>>("MC2ROframes");
+  tf.info = pc.inputs().get<TimeframeInfo>("tfinfo");
+  mChannelStats.account(pc.inputs());
+
+  mBuffers.beginTimeframe();
+  o2::ITSMFT::PixelReader* reader = nullptr;
+  size_t nDigits = 0;
+  if (mUsePacked) {
+    // the packed columns are used in place, without unpacking them into digits
+    auto rows = DataRefUtils::as<const uint16_t>(pc.inputs().get("rows"));
+    auto cols = DataRefUtils::as<const uint16_t>(pc.inputs().get("cols"));
+    auto chips = DataRefUtils::as<const PackedChipRecord>(pc.inputs().get("chips"));
+    mPackedReader.setPackedDigits(rows, cols, chips);
+    mPackedReader.setDigitsMCTruth(labels.get());
+    reader = &mPackedReader;
+    nDigits = rows.size();
+  } else {
+    // the digits are read in place as well
+    auto digits = DataRefUtils::as<const o2::ITSMFT::Digit>(pc.inputs().get("digits"));
+    mDigitReader.setDigits(digits);
+    mDigitReader.setDigitsMCTruth(labels.get());
+    reader = &mDigitReader;
+    nDigits = digits.size();
+  }
+  reader->init();
 
-  LOG(INFO) << "MFTClusterer pulled " << digits.size() << " digits, "
+  LOG(INFO) << Traits::Name << "Clusterer pulled " << nDigits << " digits, "
             << labels->getIndexedSize() << " MC label objects, in "
             << rofs.size() << " RO frames and "
             << mc2rofs.size() << " MC events";
 
-  o2::ITSMFT::DigitPixelReader reader;
-  reader.setDigits(&digits);
-  reader.setDigitsMCTruth(labels.get());
-  reader.init();
+  cluster(*reader, mc2rofs, tf);
+  mBuffers.endTimeframe();
+  mBuffers.print(getDetectorName<Mapping>("Clusterer"));
+  mChannelStats.print(getDetectorName<Mapping>("Clusterer"));
+}
+
+template <typename Mapping>
+void ClustererDPL<Mapping>::process(o2::ITSMFT::PixelReader& reader, const std::vector<o2::ITSMFT::MC2ROFRecord>& mc2rofs,
+                                    ClustersTF& tf)
+{
+  mBuffers.beginTimeframe();
+  cluster(reader, mc2rofs, tf);
+  mBuffers.endTimeframe();
+  mBuffers.print(getDetectorName<Mapping>("Clusterer"));
+}
+
+template <typename Mapping>
+void ClustererDPL<Mapping>::cluster(o2::ITSMFT::PixelReader& reader, const std::vector<o2::ITSMFT::MC2ROFRecord>& mc2rofs,
+                                    ClustersTF& tf)
+{
+  // clearing keeps the capacity of the buffers, the per-chip scratch data of
+  // the clusterer live in the clusterer itself, which is kept by the task
+  tf.compClusters.clear();
+  tf.clusters.clear();
+  tf.labels.clear();
+  tf.rofs.clear();      // To be filled in future
+  tf.mc2rofs = mc2rofs; // Simply, replicate it from digits ?
 
-  std::vector<o2::ITSMFT::CompClusterExt> compClusters;
-  std::vector<o2::ITSMFT::Cluster> clusters;
-  o2::dataformats::MCTruthContainer<o2::MCCompLabel> clusterLabels;
-  std::vector<o2::ITSMFT::ROFRecord> clusterROframes;                  // To be filled in future
-  std::vector<o2::ITSMFT::MC2ROFRecord>& clusterMC2ROframes = mc2rofs; // Simply, replicate it from digits ?
+  if (mTrace.isEnabled()) {
+    // the compact clusters are always requested, their count gives the clusters per chip
+    TracingPixelReader traced(reader, mTrace, tf.compClusters);
+    mTrace.beginTimeframe(tf.info.tfID);
+    mClusterer->process(traced, &tf.clusters, &tf.compClusters, &tf.labels);
+    traced.flush();
+    mTrace.endTimeframe();
+    mTrace.print(getDetectorName<Mapping>("Clusterer"));
+  } else {
+    mClusterer->process(reader, &tf.clusters, &tf.compClusters, &tf.labels);
+  }
 
-  mClusterer->process(reader, &clusters, &compClusters, &clusterLabels);
+  tf.global.clear();
 
-  LOG(INFO) << "MFTClusterer pushed " << clusters.size() << " clusters, in "
-            << clusterROframes.size() << " RO frames and "
-            << clusterMC2ROframes.size() << " MC events";
+  LOG(INFO) << Traits::Name << "Clusterer pushed " << tf.clusters.size() << " clusters, in "
+            << tf.rofs.size() << " RO frames and "
+            << tf.mc2rofs.size() << " MC events";
+}
 
-  pc.outputs().snapshot(Output{ "MFT", "COMPCLUSTERS", 0, Lifetime::Timeframe }, compClusters);
-  pc.outputs().snapshot(Output{ "MFT", "CLUSTERS", 0, Lifetime::Timeframe }, clusters);
-  pc.outputs().snapshot(Output{ "MFT", "CLUSTERSMCTR", 0, Lifetime::Timeframe }, clusterLabels);
-  pc.outputs().snapshot(Output{ "MFT", "MFTClusterROF", 0, Lifetime::Timeframe }, clusterROframes);
-  pc.outputs().snapshot(Output{ "MFT", "MFTClusterMC2ROF", 0, Lifetime::Timeframe }, clusterMC2ROframes);
+template <typename Mapping>
+void ClustererDPL<Mapping>::send(ProcessingContext& pc, const ClustersTF& tf)
+{
+  constexpr auto origin = Traits::Origin;
+  pc.outputs().snapshot(Output{ origin, "COMPCLUSTERS", 0, Lifetime::Timeframe }, tf.compClusters);
+  pc.outputs().snapshot(Output{ origin, "CLUSTERS", 0, Lifetime::Timeframe }, tf.clusters);
+  pc.outputs().snapshot(Output{ origin, "CLUSTERSMCTR", 0, Lifetime::Timeframe }, tf.labels);
+  pc.outputs().snapshot(Output{ origin, getDetectorDescription<Mapping>("ClusterROF"), 0, Lifetime::Timeframe }, tf.rofs);
+  pc.outputs().snapshot(Output{ origin, getDetectorDescription<Mapping>("ClusterMC2ROF"), 0, Lifetime::Timeframe }, tf.mc2rofs);
+  auto info = tf.info;
+  info.hasGlobal = mGlobal;
+  pc.outputs().snapshot(Output{ origin, getDetectorDescription<Mapping>("ClusterTFInfo"), 0, Lifetime::Timeframe }, info);
+  // x, y and z blocks, empty unless the global positions are requested,
+  // computed in the message itself
+  size_t n = mGlobal ? tf.clusters.size() : 0;
+  auto global = pc.outputs().make<float>(Output{ origin, "CLUSTERSGLO", 0, Lifetime::Timeframe }, 3 * n);
+  if (n) {
+    const auto* geom = Traits::Geometry::Instance();
+    transformClusters(tf.clusters, [geom](int chip) -> const o2::Transform3D& { return geom->getMatrixT2G(chip); },
+                      global.data(), global.data() + n, global.data() + 2 * n);
+  }
+}
 
-  mState = 2;
-  //pc.services().get<ControlService>().readyToQuit(true);
+template <typename Mapping>
+void ClustererDPL<Mapping>::transform(ClustersTF& tf) const
+{
+  tf.global.clear();
+  tf.info.hasGlobal = mGlobal;
+  if (mGlobal) {
+    const auto* geom = Traits::Geometry::Instance();
+    transformClusters(tf.clusters, [geom](int chip) -> const o2::Transform3D& { return geom->getMatrixT2G(chip); },
+                      tf.global);
+  }
 }
 
-DataProcessorSpec getClustererSpec()
+template <typename Mapping>
+DataProcessorSpec getClustererSpec(bool usePacked, int digitsSubSpec)
 {
+  constexpr auto origin = DetectorTraits<Mapping>::Origin;
+  std::vector<InputSpec> inputs;
+  if (usePacked) {
+    inputs.emplace_back("rows", origin, "PDIGROW", digitsSubSpec, Lifetime::Timeframe);
+    inputs.emplace_back("cols", origin, "PDIGCOL", digitsSubSpec, Lifetime::Timeframe);
+    inputs.emplace_back("chips", origin, "PDIGCHIP", digitsSubSpec, Lifetime::Timeframe);
+  } else {
+    inputs.emplace_back("digits", origin, "DIGITS", digitsSubSpec, Lifetime::Timeframe);
+  }
+  inputs.emplace_back("labels", origin, "DIGITSMCTR", digitsSubSpec, Lifetime::Timeframe);
+  inputs.emplace_back("ROframes", origin, getDetectorDescription<Mapping>("DigitROF"), digitsSubSpec, Lifetime::Timeframe);
+  inputs.emplace_back("MC2ROframes", origin, getDetectorDescription<Mapping>("DigitMC2ROF"), 0, Lifetime::Timeframe);
+  inputs.emplace_back("tfinfo", origin, getDetectorDescription<Mapping>("DigitTFInfo"), 0, Lifetime::Timeframe);
+
   return DataProcessorSpec{
-    "mft-clusterer",
-    Inputs{
-      InputSpec{ "digits", "MFT", "DIGITS", 0, Lifetime::Timeframe },
-      InputSpec{ "labels", "MFT", "DIGITSMCTR", 0, Lifetime::Timeframe },
-      InputSpec{ "ROframes", "MFT", "MFTDigitROF", 0, Lifetime::Timeframe },
-      InputSpec{ "MC2ROframes", "MFT", "MFTDigitMC2ROF", 0, Lifetime::Timeframe } },
+    getDetectorOption<Mapping>("-clusterer"),
+    inputs,
     Outputs{
-      OutputSpec{ "MFT", "COMPCLUSTERS", 0, Lifetime::Timeframe },
-      OutputSpec{ "MFT", "CLUSTERS", 0, Lifetime::Timeframe },
-      OutputSpec{ "MFT", "CLUSTERSMCTR", 0, Lifetime::Timeframe },
-      OutputSpec{ "MFT", "MFTClusterROF", 0, Lifetime::Timeframe },
-      OutputSpec{ "MFT", "MFTClusterMC2ROF", 0, Lifetime::Timeframe } },
-    AlgorithmSpec{ adaptFromTask<ClustererDPL>() },
+      OutputSpec{ origin, "COMPCLUSTERS", 0, Lifetime::Timeframe },
+      OutputSpec{ origin, "CLUSTERS", 0, Lifetime::Timeframe },
+      OutputSpec{ origin, "CLUSTERSMCTR", 0, Lifetime::Timeframe },
+      OutputSpec{ origin, getDetectorDescription<Mapping>("ClusterROF"), 0, Lifetime::Timeframe },
+      OutputSpec{ origin, getDetectorDescription<Mapping>("ClusterMC2ROF"), 0, Lifetime::Timeframe },
+      OutputSpec{ origin, getDetectorDescription<Mapping>("ClusterTFInfo"), 0, Lifetime::Timeframe },
+      OutputSpec{ origin, "CLUSTERSGLO", 0, Lifetime::Timeframe } },
+    AlgorithmSpec{ adaptFromTask<ClustererDPL<Mapping>>(usePacked) },
     Options{
-      { "mft-dictionary-file", VariantType::String, "complete_dictionary.bin", { "Name of the cluster-topology dictionary file" } } }
+      { getDetectorOption<Mapping>("-dictionary-file"), VariantType::String, "complete_dictionary.bin", { "Name of the cluster-topology dictionary file" } },
+      { getDetectorOption<Mapping>("-cluster-global"), VariantType::Bool, false, { "Compute the global positions of the full clusters" } },
+      { getDetectorOption<Mapping>("-buffer-trim-factor"), VariantType::Float, 2.f, { "Shrink a working buffer larger than this factor times its high-water mark" } },
+      { getDetectorOption<Mapping>("-buffer-trim-window"), VariantType::Int, 100, { "Number of timeframes over which the high-water marks are taken, 0 to never shrink" } },
+      { getDetectorOption<Mapping>("-channel-stats"), VariantType::Bool, false, { "Report the bytes received per input route" } },
+      { getDetectorOption<Mapping>("-cluster-trace"), VariantType::Bool, false, { "Time the cluster finder per chip and per RO frame" } },
+      { getDetectorOption<Mapping>("-cluster-trace-file"), VariantType::String, getDetectorOption<Mapping>("-cluster-trace.json"), { "Chrome trace file of the timed timeframes, RO frames and chips, none if empty" } },
+      { getDetectorOption<Mapping>("-cluster-trace-min-chip"), VariantType::Float, 20.f, { "Minimum time, in microseconds, of the chips written in the trace file" } },
+      { getDetectorOption<Mapping>("-cluster-trace-top"), VariantType::Int, 5, { "Number of hottest chips and RO frames reported per timeframe" } } }
   };
 }
 
+template class ClustererDPL<o2::ITSMFT::ChipMappingMFT>;
+template class ClustererDPL<o2::ITSMFT::ChipMappingITS>;
+template DataProcessorSpec getClustererSpec<o2::ITSMFT::ChipMappingMFT>(bool, int);
+template DataProcessorSpec getClustererSpec<o2::ITSMFT::ChipMappingITS>(bool, int);
+
 } // namespace MFT
 } // namespace o2
@@ -16,6 +16,14 @@
 #include <fstream>
 
 #include "ITSMFTReconstruction/Clusterer.h"
+#include "ITSMFTReconstruction/PixelReader.h"
+
+#include "MFTTestwf/TimeframeData.h"
+#include "MFTTestwf/PackedDigits.h"
+#include "MFTTestwf/BufferPool.h"
+#include "MFTTestwf/ChannelStats.h"
+#include "MFTTestwf/ClusterTrace.h"
+#include "MFTTestwf/DetectorTraits.h"
 
 #include "Framework/DataProcessorSpec.h"
 #include "Framework/Task.h"
@@ -27,22 +35,54 @@ namespace o2
 namespace MFT
 {
 
+/// cluster finder of the detector selected by its chip mapping (ChipMappingMFT, ChipMappingITS)
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
 class ClustererDPL : public Task
 {
  public:
-  ClustererDPL() = default;
+  using Traits = DetectorTraits<Mapping>;
+
+  ClustererDPL(bool usePacked) : mUsePacked(usePacked) {}
   ~ClustererDPL() = default;
   void init(InitContext& ic) final;
   void run(ProcessingContext& pc) final;
+  /// false until init succeeded
+  bool isReady() const { return mState != 0; }
+
+  /// find the clusters in the digits pulled from the inputs
+  void process(ProcessingContext& pc, ClustersTF& tf);
+  /// find the clusters in the digits provided by the pixel reader
+  void process(o2::ITSMFT::PixelReader& reader, const std::vector<o2::ITSMFT::MC2ROFRecord>& mc2rofs, ClustersTF& tf);
+  /// send the clusters as messages, the global positions are computed
+  /// directly in their output message
+  void send(ProcessingContext& pc, const ClustersTF& tf);
+  /// compute the global positions of the full clusters in tf.global, if
+  /// requested, for a consumer in the same process
+  void transform(ClustersTF& tf) const;
+  /// clusters of the current timeframe, the buffers are reused across timeframes
+  ClustersTF& getTimeframe() { return mTF; }
 
  private:
+  void cluster(o2::ITSMFT::PixelReader& reader, const std::vector<o2::ITSMFT::MC2ROFRecord>& mc2rofs, ClustersTF& tf);
+
   int mState = 0;
+  bool mUsePacked = false;
+  bool mGlobal = false; ///< compute the global positions of the full clusters
+  ClustersTF mTF;
+  DigitSpanPixelReader mDigitReader;
+  PackedDigitPixelReader mPackedReader;
+  BufferPool mBuffers;
   std::unique_ptr<std::ifstream> mFile = nullptr;
   std::unique_ptr<o2::ITSMFT::Clusterer> mClusterer = nullptr;
+  ChannelStats mChannelStats;
+  ClusterTrace mTrace;
 };
 
-/// create a processor spec and run the MFT cluster finder
-framework::DataProcessorSpec getClustererSpec();
+/// create a processor spec and run the MFT (or ITS) cluster finder
+/// (on the packed structure-of-arrays digits if usePacked is set),
+/// the digits, their labels and RO frame records are taken with the given subSpec
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
+framework::DataProcessorSpec getClustererSpec(bool usePacked = false, int digitsSubSpec = 0);
 
 } // namespace MFT
 } // namespace o2
@@ -0,0 +1,82 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DetectorTraits.h
+
+#ifndef O2_MFT_DETECTORTRAITS_H_
+#define O2_MFT_DETECTORTRAITS_H_
+
+#include <string>
+
+#include "Headers/DataHeader.h"
+#include "ITSMFTReconstruction/ChipMappingITS.h"
+#include "ITSMFTReconstruction/ChipMappingMFT.h"
+#include "ITSBase/GeometryTGeo.h"
+#include "MFTBase/GeometryTGeo.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// compile-time description of a detector served by the digit reader, the
+/// clusterer and the cluster writer specs, selected by its chip mapping:
+/// - Origin : data origin of the messages
+/// - Name   : prefix of the tree branches, of the ROF objects and of the data descriptions
+/// - Prefix : prefix of the device and option names
+/// - NChips : number of chips of the mapping
+template <typename Mapping>
+struct DetectorTraits;
+
+template <>
+struct DetectorTraits<o2::ITSMFT::ChipMappingMFT> {
+  using Geometry = o2::MFT::GeometryTGeo;
+  static constexpr o2::header::DataOrigin Origin = o2::header::gDataOriginMFT;
+  static constexpr const char* Name = "MFT";
+  static constexpr const char* Prefix = "mft";
+  static constexpr int NChips = o2::ITSMFT::ChipMappingMFT::getNChips();
+};
+
+template <>
+struct DetectorTraits<o2::ITSMFT::ChipMappingITS> {
+  using Geometry = o2::ITS::GeometryTGeo;
+  static constexpr o2::header::DataOrigin Origin = o2::header::gDataOriginITS;
+  static constexpr const char* Name = "ITS";
+  static constexpr const char* Prefix = "its";
+  static constexpr int NChips = o2::ITSMFT::ChipMappingITS::getNChips();
+};
+
+/// detector name followed by suffix, e.g. MFTDigitROF
+template <typename Mapping>
+std::string getDetectorName(const char* suffix)
+{
+  return std::string(DetectorTraits<Mapping>::Name) + suffix;
+}
+
+/// lower-case detector name followed by suffix, e.g. mft-digit-infile
+template <typename Mapping>
+std::string getDetectorOption(const char* suffix)
+{
+  return std::string(DetectorTraits<Mapping>::Prefix) + suffix;
+}
+
+/// data description made of the detector name followed by suffix, e.g. MFTDigitROF
+template <typename Mapping>
+o2::header::DataDescription getDetectorDescription(const char* suffix)
+{
+  o2::header::DataDescription desc;
+  desc.runtimeInit(getDetectorName<Mapping>(suffix).c_str());
+  return desc;
+}
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_DETECTORTRAITS */
@@ -0,0 +1,117 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DictionaryLearnerSpec.cxx
+
+#include <cmath>
+#include <cstdio>
+
+#include "MFTTestwf/DictionaryLearnerSpec.h"
+#include "MFTTestwf/TimeframeData.h"
+
+#include "Framework/ControlService.h"
+#include "DataFormatsITSMFT/ClusterTopology.h"
+#include "ITSMFTBase/SegmentationAlpide.h"
+
+using namespace o2::framework;
+using namespace o2::ITSMFT;
+
+namespace o2
+{
+namespace MFT
+{
+
+void DictionaryLearner::init(InitContext& ic)
+{
+  mOutFileName = ic.options().get<std::string>("mft-dictionary-outfile");
+  mThreshold = ic.options().get<float>("mft-dictionary-threshold");
+  mCheckpointTFs = ic.options().get<int>("mft-dictionary-checkpoint-tfs");
+  LOG(INFO) << "MFTDictionaryLearner writes " << mOutFileName.c_str() << " every "
+            << mCheckpointTFs << " timeframes and after the last one";
+  mState = 1;
+}
+
+void DictionaryLearner::account(const std::vector<Cluster>& clusters)
+{
+  // residuals alternating in sign per topology: zero mean, RMS of pitch/sqrt(12)
+  const float errX = SegmentationAlpide::PitchRow / std::sqrt(12.f);
+  const float errZ = SegmentationAlpide::PitchCol / std::sqrt(12.f);
+  unsigned char patt[Cluster::kMaxPatternBytes];
+  for (const auto& c : clusters) {
+    int rowSpan = c.getPatternRowSpan();
+    int columnSpan = c.getPatternColSpan();
+    int nBytes = (rowSpan * columnSpan) >> 3;
+    if (((rowSpan * columnSpan) % 8) != 0)
+      nBytes++;
+    c.getPattern(&patt[0], nBytes);
+    ClusterTopology topology(rowSpan, columnSpan, patt);
+    float sign = (mNAccounted[topology.getHash()]++ & 1) ? -1.f : 1.f;
+    mDictionary.accountTopology(topology, sign * errX, sign * errZ);
+  }
+  mNClusters += clusters.size();
+}
+
+void DictionaryLearner::writeSnapshot()
+{
+  // the grouping of the rare topologies cannot be undone, the statistics
+  // keep being accumulated in the original
+  BuildTopologyDictionary snapshot(mDictionary);
+  snapshot.setThreshold(mThreshold);
+  snapshot.groupRareTopologies();
+  // written aside and renamed, a clusterer never loads a partial file
+  auto tmpName = mOutFileName + ".tmp";
+  snapshot.printDictionaryBinary(tmpName);
+  if (std::rename(tmpName.c_str(), mOutFileName.c_str()) != 0) {
+    LOG(ERROR) << "Cannot write the " << mOutFileName.c_str() << " file !";
+    return;
+  }
+  LOG(INFO) << "MFTDictionaryLearner wrote the dictionary of " << mNClusters << " clusters from "
+            << mNTFs << " timeframes in " << mOutFileName.c_str();
+}
+
+void DictionaryLearner::run(ProcessingContext& pc)
+{
+  if (mState != 1)
+    return;
+
+  auto clusters = pc.inputs().get<const std::vector<Cluster>>("clusters");
+  auto info = pc.inputs().get<TimeframeInfo>("tfinfo");
+
+  account(clusters);
+  mNTFs++;
+
+  if (info.isLast() || (mCheckpointTFs > 0 && (mNTFs % mCheckpointTFs) == 0)) {
+    writeSnapshot();
+  }
+  // the cluster writer quits the workflow
+  if (info.isLast()) {
+    mState = 2;
+    pc.services().get<ControlService>().readyToQuit(false);
+  }
+}
+
+DataProcessorSpec getDictionaryLearnerSpec()
+{
+  return DataProcessorSpec{
+    "mft-dictionary-learner",
+    Inputs{
+      InputSpec{ "clusters", "MFT", "CLUSTERS", 0, Lifetime::Timeframe },
+      InputSpec{ "tfinfo", "MFT", "MFTClusterTFInfo", 0, Lifetime::Timeframe } },
+    Outputs{},
+    AlgorithmSpec{ adaptFromTask<DictionaryLearner>() },
+    Options{
+      { "mft-dictionary-outfile", VariantType::String, "learned_dictionary.bin", { "Name of the learned dictionary file" } },
+      { "mft-dictionary-threshold", VariantType::Float, 0.0001f, { "Frequency below which the topologies are grouped" } },
+      { "mft-dictionary-checkpoint-tfs", VariantType::Int, 0, { "Write the dictionary every N timeframes, 0 for after the last one only" } } }
+  };
+}
+
+} // namespace MFT
+} // namespace o2
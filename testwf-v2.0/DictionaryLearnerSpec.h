@@ -0,0 +1,70 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DictionaryLearnerSpec.h
+
+#ifndef O2_MFT_DICTIONARYLEARNER_H_
+#define O2_MFT_DICTIONARYLEARNER_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/Task.h"
+
+#include "DataFormatsITSMFT/Cluster.h"
+#include "ITSMFTReconstruction/BuildTopologyDictionary.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+/// accumulate the cluster topologies over the timeframes and write a
+/// snapshot of the topology dictionary every N timeframes and after the
+/// last one; the MC hits are not known online, each topology is accounted
+/// with residuals of +-pitch/sqrt(12) in turn, which gives it the default
+/// errors of a hit uniform over the pixel (PitchRow/sqrt(12) in x,
+/// PitchCol/sqrt(12) in z) and leaves its centre of gravity unbiased
+class DictionaryLearner : public Task
+{
+ public:
+  DictionaryLearner() = default;
+  ~DictionaryLearner() = default;
+  void init(InitContext& ic) final;
+  void run(ProcessingContext& pc) final;
+
+  /// account the topologies of the clusters of a timeframe
+  void account(const std::vector<o2::ITSMFT::Cluster>& clusters);
+  /// group the rare topologies of a copy of the statistics and write it
+  void writeSnapshot();
+
+ private:
+  int mState = 0;
+  o2::ITSMFT::BuildTopologyDictionary mDictionary;
+  std::string mOutFileName;
+  float mThreshold = 0.0001f;
+  int mCheckpointTFs = 0;   ///< timeframes between the snapshots, 0 for the last one only
+  int mNTFs = 0;
+  size_t mNClusters = 0;
+  std::unordered_map<unsigned long, uint32_t> mNAccounted; ///< clusters accounted per topology hash, for the residual sign
+};
+
+/// create a processor spec
+/// learn the topology dictionary from the clusters sent by the clusterer
+framework::DataProcessorSpec getDictionaryLearnerSpec();
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_DICTIONARYLEARNER */
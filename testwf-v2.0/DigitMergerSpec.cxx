@@ -0,0 +1,137 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DigitMergerSpec.cxx
+
+#include <vector>
+
+#include "MFTTestwf/DigitMergerSpec.h"
+#include "MFTTestwf/DigitReaderSpec.h"
+#include "MFTTestwf/Checkpoint.h"
+
+#include "ITSMFTBase/Digit.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+#include "DataFormatsITSMFT/ROFRecord.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+void DigitMerger::init(InitContext& ic)
+{
+  LOG(INFO) << "MFTDigitMerger merges the digits of " << mNReaders << " readers";
+  // the RO frames go on after the ones of the timeframes committed before a restart
+  Checkpoint progress;
+  if (ic.options().get<bool>("mft-resume") && progress.read(ic.options().get<std::string>("mft-checkpoint-file"))) {
+    if (progress.nReaders != uint32_t(mNReaders)) {
+      LOG(ERROR) << "MFTDigitMerger cannot resume, the progress manifest was written with " << progress.nReaders
+                 << " readers and this run has " << mNReaders << " !";
+      mState = 0;
+      return;
+    }
+    mNextROF = progress.nextROF;
+    LOG(INFO) << "MFTDigitMerger resumes at timeframe " << progress.nWritten << ", RO frame " << mNextROF;
+  }
+  mState = 1;
+}
+
+void DigitMerger::append(DigitsTF& dst, DigitsTF& src)
+{
+  mNextROF = shiftROFrames(src, mNextROF);
+  // the MC events point to the RO frame records of their own file
+  int rofOffset = dst.rofs.size();
+  for (auto& mc2rof : src.mc2rofs) {
+    if (mc2rof.rofRecordID >= 0) {
+      mc2rof.rofRecordID += rofOffset;
+    }
+  }
+  // the RO frame records point to the digits of their own file, which follow
+  // the ones already merged in the single block of the timeframe (event 0)
+  int digitOffset = dst.digits.size();
+  for (auto& rof : src.rofs) {
+    rof.getROFEntry().setEvent(0);
+    rof.getROFEntry().setIndex(rof.getROFEntry().getIndex() + digitOffset);
+  }
+  dst.digits.insert(dst.digits.end(), src.digits.begin(), src.digits.end());
+  dst.labels.mergeAtBack(src.labels);
+  dst.rofs.insert(dst.rofs.end(), src.rofs.begin(), src.rofs.end());
+  dst.mc2rofs.insert(dst.mc2rofs.end(), src.mc2rofs.begin(), src.mc2rofs.end());
+}
+
+void DigitMerger::run(ProcessingContext& pc)
+{
+  if (mState != 1)
+    return;
+
+  // the inputs of a timeslice are the same round of all the readers, reader i
+  // holding the file i of the round
+  DigitsTF tf;
+  for (int i = 0; i < mNReaders; i++) {
+    auto id = std::to_string(i);
+    DigitsTF part;
+    part.digits = pc.inputs().get<const std::vector<o2::ITSMFT::Digit>>(("digits" + id).c_str());
+    auto labels = pc.inputs().get<const o2::dataformats::MCTruthContainer<o2::MCCompLabel>*>(("labels" + id).c_str());
+    part.labels.mergeAtBack(*labels.get());
+    part.rofs = pc.inputs().get<const std::vector<o2::ITSMFT::ROFRecord>>(("ROframes" + id).c_str());
+    part.mc2rofs = pc.inputs().get<const std::vector<o2::ITSMFT::MC2ROFRecord>>(("MC2ROframes" + id).c_str());
+    auto info = pc.inputs().get<TimeframeInfo>(("tfinfo" + id).c_str());
+    if (i == 0) {
+      tf.info = info;
+    } else if (info.tfID != tf.info.tfID) {
+      LOG(ERROR) << "MFTDigitMerger got timeframe " << info.tfID << " from reader " << i
+                 << " while merging timeframe " << tf.info.tfID;
+    }
+    append(tf, part);
+  }
+  tf.info.nextROF = mNextROF;
+
+  LOG(INFO) << "MFTDigitMerger pushed " << tf.digits.size() << " digits, in "
+            << tf.rofs.size() << " RO frames and "
+            << tf.mc2rofs.size() << " MC events, timeframe "
+            << tf.info.tfID << "/" << tf.info.nTFs;
+  sendDigits(pc.outputs(), 0, mUsePacked, tf);
+
+  if (tf.info.isLast()) {
+    mState = 2;
+  }
+}
+
+DataProcessorSpec getDigitMergerSpec(bool usePacked, int nReaders)
+{
+  std::vector<InputSpec> inputs;
+  for (int i = 0; i < nReaders; i++) {
+    auto id = std::to_string(i);
+    int subSpec = getDigitReaderSubSpec(i, nReaders);
+    inputs.emplace_back("digits" + id, "MFT", "DIGITS", subSpec, Lifetime::Timeframe);
+    inputs.emplace_back("labels" + id, "MFT", "DIGITSMCTR", subSpec, Lifetime::Timeframe);
+    inputs.emplace_back("ROframes" + id, "MFT", "MFTDigitROF", subSpec, Lifetime::Timeframe);
+    inputs.emplace_back("MC2ROframes" + id, "MFT", "MFTDigitMC2ROF", subSpec, Lifetime::Timeframe);
+    inputs.emplace_back("tfinfo" + id, "MFT", "MFTDigitTFInfo", subSpec, Lifetime::Timeframe);
+  }
+  std::vector<OutputSpec> outputs;
+  addDigitOutputs(outputs, 0, usePacked);
+
+  return DataProcessorSpec{
+    "mft-digit-merger",
+    inputs,
+    outputs,
+    AlgorithmSpec{ adaptFromTask<DigitMerger>(usePacked, nReaders) },
+    Options{
+      { "mft-checkpoint-file", VariantType::String, "mftclusters.progress", { "Progress manifest of the cluster production" } },
+      { "mft-resume", VariantType::Bool, false, { "Resume the production after the timeframes committed in the progress manifest" } } }
+  };
+}
+
+} // namespace MFT
+} // namespace o2
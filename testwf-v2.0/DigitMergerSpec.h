@@ -0,0 +1,56 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DigitMergerSpec.h
+
+#ifndef O2_MFT_DIGITMERGER_H_
+#define O2_MFT_DIGITMERGER_H_
+
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/Task.h"
+
+#include "MFTTestwf/TimeframeData.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+/// fan-in of several digit readers: the timeframes of a round, one per
+/// reader, are concatenated in the order of the input files and sent as a
+/// single timeframe, with the RO frames shifted to be unique over the run
+class DigitMerger : public Task
+{
+ public:
+  DigitMerger(bool usePacked, int nReaders) : mUsePacked(usePacked), mNReaders(nReaders) {}
+  ~DigitMerger() = default;
+  void init(InitContext& ic) final;
+  void run(ProcessingContext& pc) final;
+
+  /// append the digits of src to dst, src is left in an undefined state
+  void append(DigitsTF& dst, DigitsTF& src);
+
+ private:
+  int mState = 0;
+  bool mUsePacked = false;
+  int mNReaders = 1;
+  uint32_t mNextROF = 0; ///< first free RO frame
+};
+
+/// create a processor spec
+/// merge the digits of nReaders digit readers
+framework::DataProcessorSpec getDigitMergerSpec(bool usePacked, int nReaders);
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_DIGITMERGER */
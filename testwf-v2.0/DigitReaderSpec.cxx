@@ -0,0 +1,325 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DigitReaderSpec.cxx
+
+#include <vector>
+#include <iterator>
+#include <sstream>
+#include <glob.h>
+
+#include "MFTTestwf/DigitReaderSpec.h"
+#include "MFTTestwf/PackedDigits.h"
+
+#include "TTree.h"
+#include "Framework/ControlService.h"
+#include "ITSMFTBase/Digit.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+#include "DataFormatsITSMFT/ROFRecord.h"
+
+using namespace o2::framework;
+using namespace o2::ITSMFT;
+
+namespace o2
+{
+namespace MFT
+{
+
+template <typename Mapping>
+std::vector<std::string> DigitReader<Mapping>::expandFileList(const std::string& list)
+{
+  std::vector<std::string> files;
+  std::istringstream stream(list);
+  std::string pattern;
+  while (std::getline(stream, pattern, ',')) {
+    if (pattern.empty()) {
+      continue;
+    }
+    glob_t matches;
+    if (glob(pattern.c_str(), GLOB_NOCHECK, nullptr, &matches) == 0) {
+      for (size_t i = 0; i < matches.gl_pathc; i++) {
+        files.emplace_back(matches.gl_pathv[i]);
+      }
+    }
+    globfree(&matches);
+  }
+  return files;
+}
+
+template <typename Mapping>
+void DigitReader<Mapping>::init(InitContext& ic)
+{
+  // all the instances expand the same list, glob returns the matches sorted
+  auto files = expandFileList(ic.options().get<std::string>(getDetectorOption<Mapping>("-digit-infile")));
+  if (files.empty()) {
+    LOG(ERROR) << "No " << Traits::Name << " digit file to read !";
+    mState = 0;
+    return;
+  }
+  for (size_t i = mInstance; i < files.size(); i += mNInstances) {
+    mFiles.push_back(files[i]);
+  }
+  mNTFs = (files.size() + mNInstances - 1) / mNInstances;
+  LOG(INFO) << Traits::Name << "DigitReader " << mInstance << "/" << mNInstances << " reads "
+            << mFiles.size() << " of " << files.size() << " files in " << mNTFs << " timeframes";
+
+  mSortDigits = ic.options().get<bool>(getDetectorOption<Mapping>("-digit-sort"));
+  mNSortThreads = ic.options().get<int>(getDetectorOption<Mapping>("-digit-sort-threads"));
+  if (mSortDigits) {
+    auto nChips = ic.options().get<int>(getDetectorOption<Mapping>("-nchips"));
+    if (!mSorter.setNChips(nChips)) {
+      LOG(ERROR) << Traits::Name << "DigitReader cannot sort the digits of " << nChips << " chips, the sort key holds at most "
+                 << DigitSorter::MaxNChips << " !";
+      mState = 0;
+      return;
+    }
+    LOG(INFO) << Traits::Name << "DigitReader validates and sorts the digits of " << mSorter.getNChips()
+              << " chips (" << mSorter.getChipBits() << " bits of the sort key) with " << mNSortThreads << " threads";
+  }
+
+  Checkpoint progress;
+  auto checkpointFile = ic.options().get<std::string>(getDetectorOption<Mapping>("-checkpoint-file"));
+  if (ic.options().get<bool>(getDetectorOption<Mapping>("-resume")) && progress.read(checkpointFile)) {
+    if (progress.nTFs != mNTFs) {
+      LOG(ERROR) << Traits::Name << "DigitReader cannot resume from " << checkpointFile.c_str() << ", it counts "
+                 << progress.nTFs << " timeframes and the input files " << mNTFs << " !";
+      mState = 0;
+      return;
+    }
+    // the timeframes are rounds of one file per reader, they change with the number of readers
+    if (progress.nReaders != uint32_t(mNInstances)) {
+      LOG(ERROR) << Traits::Name << "DigitReader cannot resume from " << checkpointFile.c_str() << ", it was written with "
+                 << progress.nReaders << " readers and this run has " << mNInstances << " !";
+      mState = 0;
+      return;
+    }
+    mTF = progress.nWritten;
+    mNextROF = progress.nextROF;
+    LOG(INFO) << Traits::Name << "DigitReader " << mInstance << " resumes at timeframe " << mTF << "/" << mNTFs
+              << ", RO frame " << mNextROF;
+  }
+
+  mMaxInFlight = ic.options().get<int>(getDetectorOption<Mapping>("-max-inflight-tfs"));
+  if (mMaxInFlight > 0) {
+    // nothing is acknowledged before the first timeframe is sent by all the
+    // readers, except the timeframes committed before a restart
+    auto id = FlowControl::getId(ic.options().get<std::string>(getDetectorOption<Mapping>("-flow-control-id")),
+                                 getDetectorOption<Mapping>("-flow-control"));
+    if (!mFlowControl.open(id, true)) {
+      mState = 0;
+      return;
+    }
+    if (mTF > 0) {
+      mFlowControl.acknowledge(mTF - 1);
+    }
+    LOG(INFO) << Traits::Name << "DigitReader sends at most " << mMaxInFlight << " timeframes ahead of the cluster writer";
+  }
+
+  mState = 1;
+}
+
+template <typename Mapping>
+bool DigitReader<Mapping>::read(DigitsTF& tf)
+{
+  if (isDone()) {
+    return false;
+  }
+  if (mMaxInFlight > 0) {
+    mStallTime += mFlowControl.waitForCredit(mTF, mMaxInFlight);
+  }
+  tf.info.tfID = mTF;
+  tf.info.nTFs = mNTFs;
+  tf.info.nReaders = mNInstances;
+  tf.digits.clear();
+  tf.labels.clear();
+  tf.rofs.clear();
+  tf.mc2rofs.clear();
+  // a file which cannot be read gives an empty timeframe, the other
+  // readers and the devices downstream keep the timeframe order
+  if (mTF < mFiles.size()) {
+    readFile(mFiles[mTF], tf);
+  }
+  if (mNInstances == 1) {
+    mNextROF = shiftROFrames(tf, mNextROF);
+    tf.info.nextROF = mNextROF;
+  }
+  mTF++;
+  if (isDone() && mMaxInFlight > 0) {
+    LOG(INFO) << Traits::Name << "DigitReader " << mInstance << " stalled " << mStallTime << " s waiting for the cluster writer";
+  }
+  return true;
+}
+
+template <typename Mapping>
+bool DigitReader<Mapping>::readFile(const std::string& filename, DigitsTF& tf)
+{
+  std::unique_ptr<TFile> file = std::make_unique<TFile>(filename.c_str(), "OLD");
+  if (!file->IsOpen()) {
+    LOG(ERROR) << "Cannot open the " << filename.c_str() << " file !";
+    return false;
+  }
+  std::unique_ptr<TTree> tree((TTree*)file->Get("o2sim"));
+  std::unique_ptr<std::vector<ROFRecord>> rofs((std::vector<ROFRecord>*)file->Get(getDetectorName<Mapping>("DigitROF").c_str()));
+  std::unique_ptr<std::vector<MC2ROFRecord>> mc2rofs((std::vector<MC2ROFRecord>*)file->Get(getDetectorName<Mapping>("DigitMC2ROF").c_str()));
+  if (!tree || !rofs || !mc2rofs) {
+    LOG(ERROR) << "Cannot read the " << Traits::Name << " digits from " << filename.c_str() << " !";
+    return false;
+  }
+
+  std::vector<o2::ITSMFT::Digit> digits, *pdigits = &digits;
+  tree->SetBranchAddress(getDetectorName<Mapping>("Digit").c_str(), &pdigits);
+  o2::dataformats::MCTruthContainer<o2::MCCompLabel> labels, *plabels = &labels;
+  tree->SetBranchAddress(getDetectorName<Mapping>("DigitMCTruth").c_str(), &plabels);
+
+  int ne = tree->GetEntries();
+  if (mSortDigits) {
+    // keep the entries apart, they are validated and sorted in parallel
+    std::vector<std::vector<o2::ITSMFT::Digit>> entryDigits(ne);
+    std::vector<o2::dataformats::MCTruthContainer<o2::MCCompLabel>> entryLabels(ne);
+    for (int e = 0; e < ne; e++) {
+      tree->GetEntry(e);
+      entryDigits[e].swap(digits);
+      entryLabels[e].swap(labels);
+    }
+    DigitSorterStats stats;
+    mSorter.process(entryDigits, entryLabels, tf.digits, tf.labels, stats, mNSortThreads);
+    LOG(INFO) << Traits::Name << "DigitReader validated " << stats.nDigits << " digits, dropped "
+              << stats.nBadChip << " with bad chip ID, "
+              << stats.nBadRow << " with bad row, "
+              << stats.nBadCol << " with bad column, "
+              << stats.nBadROF << " with too large RO frame, sorted "
+              << stats.nSorted << " out-of-order blocks";
+  } else {
+    for (int e = 0; e < ne; e++) {
+      tree->GetEntry(e);
+      std::copy(digits.begin(), digits.end(), std::back_inserter(tf.digits));
+      tf.labels.mergeAtBack(labels);
+    }
+  }
+  tf.rofs.swap(*rofs.get());
+  tf.mc2rofs.swap(*mc2rofs.get());
+  // without the sorting, the records keep pointing to the digits of their tree entry
+  if (mSortDigits) {
+    DigitSorter::fillROFRecords(tf.digits, tf.rofs);
+  }
+  return true;
+}
+
+int getDigitReaderSubSpec(int instance, int nInstances)
+{
+  // clear of the subSpec 1 of the noise filter
+  return nInstances > 1 ? 16 + instance : 0;
+}
+
+template <typename Mapping>
+void addDigitOutputs(std::vector<OutputSpec>& outputs, int subSpec, bool usePacked)
+{
+  constexpr auto origin = DetectorTraits<Mapping>::Origin;
+  if (usePacked) {
+    outputs.emplace_back(origin, "PDIGROW", subSpec, Lifetime::Timeframe);
+    outputs.emplace_back(origin, "PDIGCOL", subSpec, Lifetime::Timeframe);
+    outputs.emplace_back(origin, "PDIGCHIP", subSpec, Lifetime::Timeframe);
+  } else {
+    outputs.emplace_back(origin, "DIGITS", subSpec, Lifetime::Timeframe);
+  }
+  outputs.emplace_back(origin, "DIGITSMCTR", subSpec, Lifetime::Timeframe);
+  outputs.emplace_back(origin, getDetectorDescription<Mapping>("DigitROF"), subSpec, Lifetime::Timeframe);
+  outputs.emplace_back(origin, getDetectorDescription<Mapping>("DigitMC2ROF"), subSpec, Lifetime::Timeframe);
+  outputs.emplace_back(origin, getDetectorDescription<Mapping>("DigitTFInfo"), subSpec, Lifetime::Timeframe);
+}
+
+template <typename Mapping>
+void sendDigits(DataAllocator& outputs, int subSpec, bool usePacked, DigitsTF& tf)
+{
+  constexpr auto origin = DetectorTraits<Mapping>::Origin;
+  if (usePacked) {
+    sendPackedDigits(outputs, subSpec, tf.digits, tf.labels, origin);
+  } else {
+    outputs.snapshot(Output{ origin, "DIGITS", subSpec, Lifetime::Timeframe }, tf.digits);
+  }
+  outputs.snapshot(Output{ origin, "DIGITSMCTR", subSpec, Lifetime::Timeframe }, tf.labels);
+  outputs.snapshot(Output{ origin, getDetectorDescription<Mapping>("DigitROF"), subSpec, Lifetime::Timeframe }, tf.rofs);
+  outputs.snapshot(Output{ origin, getDetectorDescription<Mapping>("DigitMC2ROF"), subSpec, Lifetime::Timeframe }, tf.mc2rofs);
+  outputs.snapshot(Output{ origin, getDetectorDescription<Mapping>("DigitTFInfo"), subSpec, Lifetime::Timeframe }, tf.info);
+}
+
+template <typename Mapping>
+void DigitReader<Mapping>::send(ProcessingContext& pc, DigitsTF& tf)
+{
+  LOG(INFO) << Traits::Name << "DigitReader pushed " << tf.digits.size() << " digits, in "
+            << tf.rofs.size() << " RO frames and "
+            << tf.mc2rofs.size() << " MC events, timeframe "
+            << tf.info.tfID << "/" << tf.info.nTFs;
+  sendDigits<Mapping>(pc.outputs(), getDigitReaderSubSpec(mInstance, mNInstances), mUsePacked, tf);
+}
+
+template <typename Mapping>
+void DigitReader<Mapping>::run(ProcessingContext& pc)
+{
+  if (mState != 1)
+    return;
+
+  // resumed after the last timeframe: nothing is sent, nothing will quit downstream
+  if (isDone()) {
+    LOG(INFO) << Traits::Name << "DigitReader " << mInstance << ": all the timeframes are already written";
+    mState = 2;
+    pc.services().get<ControlService>().readyToQuit(true);
+    return;
+  }
+
+  DigitsTF tf;
+  if (!read(tf)) {
+    return;
+  }
+  send(pc, tf);
+
+  // the devices downstream quit the workflow once the last timeframe is written
+  if (isDone()) {
+    mState = 2;
+    pc.services().get<ControlService>().readyToQuit(false);
+  }
+}
+
+template <typename Mapping>
+DataProcessorSpec getDigitReaderSpec(bool usePacked, int instance, int nInstances)
+{
+  std::vector<OutputSpec> outputs;
+  addDigitOutputs<Mapping>(outputs, getDigitReaderSubSpec(instance, nInstances), usePacked);
+
+  auto name = getDetectorOption<Mapping>("-digit-reader");
+  return DataProcessorSpec{
+    nInstances > 1 ? name + "-" + std::to_string(instance) : name,
+    Inputs{},
+    outputs,
+    AlgorithmSpec{ adaptFromTask<DigitReader<Mapping>>(usePacked, instance, nInstances) },
+    Options{
+      { getDetectorOption<Mapping>("-digit-infile"), VariantType::String, getDetectorOption<Mapping>("digits.root").c_str(), { "Name of the input file, or comma-separated list of files and glob patterns" } },
+      { getDetectorOption<Mapping>("-digit-sort"), VariantType::Bool, false, { "Validate the digits and sort them by ROF, chip, column and row" } },
+      { getDetectorOption<Mapping>("-digit-sort-threads"), VariantType::Int, 1, { "Number of threads sorting the tree entries" } },
+      { getDetectorOption<Mapping>("-nchips"), VariantType::Int, DetectorTraits<Mapping>::NChips, { "Number of chips, digits with larger chip ID are dropped" } },
+      { getDetectorOption<Mapping>("-max-inflight-tfs"), VariantType::Int, 0, { "Maximum number of timeframes sent and not yet written, 0 for no limit" } },
+      { getDetectorOption<Mapping>("-flow-control-id"), VariantType::String, "", { "Name of the flow control block shared by the readers and the cluster writer, by default <detector>-flow-control-<driver pid>" } },
+      { getDetectorOption<Mapping>("-checkpoint-file"), VariantType::String, getDetectorOption<Mapping>("clusters.progress").c_str(), { "Progress manifest of the cluster production" } },
+      { getDetectorOption<Mapping>("-resume"), VariantType::Bool, false, { "Resume the production after the timeframes committed in the progress manifest" } } }
+  };
+}
+
+template class DigitReader<o2::ITSMFT::ChipMappingMFT>;
+template class DigitReader<o2::ITSMFT::ChipMappingITS>;
+template void addDigitOutputs<o2::ITSMFT::ChipMappingMFT>(std::vector<OutputSpec>&, int, bool);
+template void addDigitOutputs<o2::ITSMFT::ChipMappingITS>(std::vector<OutputSpec>&, int, bool);
+template void sendDigits<o2::ITSMFT::ChipMappingMFT>(DataAllocator&, int, bool, DigitsTF&);
+template void sendDigits<o2::ITSMFT::ChipMappingITS>(DataAllocator&, int, bool, DigitsTF&);
+template DataProcessorSpec getDigitReaderSpec<o2::ITSMFT::ChipMappingMFT>(bool, int, int);
+template DataProcessorSpec getDigitReaderSpec<o2::ITSMFT::ChipMappingITS>(bool, int, int);
+
+} // namespace MFT
+} // namespace o2
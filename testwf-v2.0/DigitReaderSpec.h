@@ -0,0 +1,107 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DigitReaderSpec.h
+
+#ifndef O2_MFT_DIGITREADER_H_
+#define O2_MFT_DIGITREADER_H_
+
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/DataAllocator.h"
+#include "Framework/Task.h"
+
+#include "MFTTestwf/DigitSorter.h"
+#include "MFTTestwf/FlowControl.h"
+#include "MFTTestwf/Checkpoint.h"
+#include "MFTTestwf/TimeframeData.h"
+#include "MFTTestwf/DetectorTraits.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+/// each input file is one timeframe; with several reader instances, the
+/// files are dealt round-robin and the instances send on their own subSpec;
+/// the detector is selected by its chip mapping (ChipMappingMFT, ChipMappingITS)
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
+class DigitReader : public Task
+{
+ public:
+  using Traits = DetectorTraits<Mapping>;
+
+  DigitReader(bool usePacked, int instance = 0, int nInstances = 1)
+    : mUsePacked(usePacked), mInstance(instance), mNInstances(nInstances) {}
+  ~DigitReader() = default;
+  void init(InitContext& ic) final;
+  void run(ProcessingContext& pc) final;
+
+  /// read the digits of the next input file, an instance without a file in
+  /// the current round returns an empty timeframe; false when all are read;
+  /// with flow control, wait first for the cluster writer to free a credit;
+  /// when resuming, the timeframes committed by the cluster writer are skipped
+  bool read(DigitsTF& tf);
+  /// send the digits as messages
+  void send(ProcessingContext& pc, DigitsTF& tf);
+  bool isDone() const { return mTF >= mNTFs; }
+  /// false until init succeeded
+  bool isReady() const { return mState != 0; }
+
+  /// expand a comma-separated list of file names and glob patterns
+  static std::vector<std::string> expandFileList(const std::string& list);
+
+ private:
+  bool readFile(const std::string& filename, DigitsTF& tf);
+
+  int mState = 0;
+  bool mUsePacked = false;
+  int mInstance = 0;
+  int mNInstances = 1;
+  bool mSortDigits = false;
+  int mNSortThreads = 1;
+  DigitSorter mSorter;
+  std::vector<std::string> mFiles; ///< files of this instance
+  uint32_t mTF = 0;                ///< next timeframe (round) to read
+  uint32_t mNTFs = 0;              ///< number of timeframes (rounds) in the run
+  uint32_t mNextROF = 0;           ///< first free RO frame, single instance only
+  uint32_t mMaxInFlight = 0;       ///< maximum number of timeframes not yet written, 0 for no limit
+  double mStallTime = 0.;          ///< time spent waiting for credits, in seconds
+  FlowControl mFlowControl;
+};
+
+/// subSpec of the outputs of a reader instance: 0 for a single reader, the
+/// digit merger takes the outputs of several readers and sends them on 0
+int getDigitReaderSubSpec(int instance, int nInstances);
+
+/// add the output specs of the digits sent with sendDigits
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
+void addDigitOutputs(std::vector<OutputSpec>& outputs, int subSpec, bool usePacked);
+
+/// send the digits of a timeframe, packed if usePacked is set
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
+void sendDigits(o2::framework::DataAllocator& outputs, int subSpec, bool usePacked, DigitsTF& tf);
+
+/// create a processor spec
+/// read simulated MFT (or ITS) digits from a list of root files
+/// (send them in the packed structure-of-arrays format if usePacked is set)
+template <typename Mapping = o2::ITSMFT::ChipMappingMFT>
+framework::DataProcessorSpec getDigitReaderSpec(bool usePacked = false, int instance = 0, int nInstances = 1);
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_DIGITREADER */
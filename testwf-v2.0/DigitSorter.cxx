@@ -0,0 +1,194 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DigitSorter.cxx
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <numeric>
+#include <thread>
+
+#include "MFTTestwf/DigitSorter.h"
+#include "MFTTestwf/PackedDigits.h"
+
+#include "ITSMFTBase/SegmentationAlpide.h"
+
+using namespace o2::ITSMFT;
+
+namespace o2
+{
+namespace MFT
+{
+
+void DigitSorterStats::add(const DigitSorterStats& other)
+{
+  nDigits += other.nDigits;
+  nBadChip += other.nBadChip;
+  nBadRow += other.nBadRow;
+  nBadCol += other.nBadCol;
+  nBadROF += other.nBadROF;
+  nSorted += other.nSorted;
+}
+
+void DigitSorter::radixSort(std::vector<uint64_t>& keys, std::vector<int>& order)
+{
+  // LSD radix sort on 8-bit digits, the passes on bytes which are identical
+  // for all the keys (e.g. the upper bits of the RO frame) are skipped
+  auto n = keys.size();
+  std::vector<uint64_t> keysTmp(n);
+  std::vector<int> orderTmp(n);
+  uint64_t allOr = 0, allAnd = ~uint64_t(0);
+  for (auto k : keys) {
+    allOr |= k;
+    allAnd &= k;
+  }
+  auto varying = allOr ^ allAnd;
+  for (int shift = 0; shift < 64; shift += 8) {
+    if (((varying >> shift) & 0xff) == 0) {
+      continue;
+    }
+    size_t count[257] = { 0 };
+    for (auto k : keys) {
+      count[((k >> shift) & 0xff) + 1]++;
+    }
+    for (int i = 0; i < 256; i++) {
+      count[i + 1] += count[i];
+    }
+    for (size_t i = 0; i < n; i++) {
+      auto pos = count[(keys[i] >> shift) & 0xff]++;
+      keysTmp[pos] = keys[i];
+      orderTmp[pos] = order[i];
+    }
+    keys.swap(keysTmp);
+    order.swap(orderTmp);
+  }
+}
+
+void DigitSorter::process(std::vector<Digit>& digits, Labels& labels, DigitSorterStats& stats) const
+{
+  auto n = digits.size();
+  stats.nDigits += n;
+
+  auto maxNROFs = getMaxNROFs();
+  std::vector<int> order;
+  std::vector<uint64_t> keys;
+  order.reserve(n);
+  keys.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    const auto& d = digits[i];
+    if (d.getChipIndex() >= mNChips) {
+      stats.nBadChip++;
+      continue;
+    }
+    if (d.getRow() >= SegmentationAlpide::NRows) {
+      stats.nBadRow++;
+      continue;
+    }
+    if (d.getColumn() >= SegmentationAlpide::NCols) {
+      stats.nBadCol++;
+      continue;
+    }
+    if (d.getROFrame() >= maxNROFs) {
+      stats.nBadROF++;
+      continue;
+    }
+    order.push_back(i);
+    keys.push_back(getKey(d));
+  }
+
+  bool sorted = std::is_sorted(keys.begin(), keys.end());
+  if (sorted && order.size() == n) {
+    return;
+  }
+  if (!sorted) {
+    radixSort(keys, order);
+    stats.nSorted++;
+  }
+
+  std::vector<Digit> sortedDigits;
+  sortedDigits.reserve(order.size());
+  for (auto i : order) {
+    sortedDigits.push_back(digits[i]);
+  }
+  digits.swap(sortedDigits);
+
+  Labels sortedLabels;
+  PackedDigits::reorderLabels(labels, order, sortedLabels);
+  labels.swap(sortedLabels);
+}
+
+void DigitSorter::process(std::vector<std::vector<Digit>>& blocks, std::vector<Labels>& blockLabels,
+                          std::vector<Digit>& digits, Labels& labels, DigitSorterStats& stats, int nThreads) const
+{
+  auto nBlocks = blocks.size();
+  std::vector<DigitSorterStats> blockStats(nBlocks);
+
+  std::atomic<size_t> next{ 0 };
+  auto worker = [&]() {
+    for (auto ib = next++; ib < nBlocks; ib = next++) {
+      process(blocks[ib], blockLabels[ib], blockStats[ib]);
+    }
+  };
+  nThreads = std::max(1, std::min(nThreads, int(nBlocks)));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < nThreads; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  size_t nTot = 0;
+  for (const auto& b : blocks) {
+    nTot += b.size();
+  }
+  digits.clear();
+  digits.reserve(nTot);
+  labels.clear();
+  bool ordered = true;
+  for (size_t ib = 0; ib < nBlocks; ib++) {
+    stats.add(blockStats[ib]);
+    if (blocks[ib].empty()) {
+      continue;
+    }
+    if (!digits.empty() && getKey(digits.back()) > getKey(blocks[ib].front())) {
+      ordered = false;
+    }
+    std::copy(blocks[ib].begin(), blocks[ib].end(), std::back_inserter(digits));
+    labels.mergeAtBack(blockLabels[ib]);
+  }
+
+  // the tree entries overlap in RO frames, sort the concatenated digits once more
+  if (!ordered) {
+    DigitSorterStats globalStats;
+    process(digits, labels, globalStats);
+    stats.nSorted += globalStats.nSorted;
+  }
+}
+
+void DigitSorter::fillROFRecords(const std::vector<Digit>& digits, std::vector<ROFRecord>& rofs)
+{
+  auto lessROF = [](const Digit& d, uint32_t rof) { return d.getROFrame() < rof; };
+  for (auto& rof : rofs) {
+    auto first = std::lower_bound(digits.begin(), digits.end(), uint32_t(rof.getROFrame()), lessROF);
+    auto last = first;
+    while (last != digits.end() && last->getROFrame() == rof.getROFrame()) {
+      ++last;
+    }
+    rof.getROFEntry().setEvent(0);
+    rof.getROFEntry().setIndex(std::distance(digits.begin(), first));
+    rof.setNROFEntries(std::distance(first, last));
+  }
+}
+
+} // namespace MFT
+} // namespace o2
@@ -0,0 +1,107 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   DigitSorter.h
+
+#ifndef O2_MFT_DIGITSORTER_H_
+#define O2_MFT_DIGITSORTER_H_
+
+#include <vector>
+#include <cstdint>
+
+#include "ITSMFTBase/Digit.h"
+#include "DataFormatsITSMFT/ROFRecord.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// counters of the digits validation
+struct DigitSorterStats {
+  size_t nDigits = 0;  ///< digits seen
+  size_t nBadChip = 0; ///< dropped, chip index out of range
+  size_t nBadRow = 0;  ///< dropped, row out of range
+  size_t nBadCol = 0;  ///< dropped, column out of range
+  size_t nBadROF = 0;  ///< dropped, RO frame beyond the RO frame field of the key
+  size_t nSorted = 0;  ///< blocks which were not already in order
+
+  void add(const DigitSorterStats& other);
+  size_t getNDropped() const { return nBadChip + nBadRow + nBadCol + nBadROF; }
+};
+
+/// validate the digits and radix-sort them by (RO frame, chip, column, row)
+class DigitSorter
+{
+ public:
+  using Labels = o2::dataformats::MCTruthContainer<o2::MCCompLabel>;
+
+  // widths of the sort key fields: the chip field is as wide as the number
+  // of chips needs, the RO frame takes the upper bits left
+  static constexpr int RowBits = 9;
+  static constexpr int ColBits = 10;
+  static constexpr int MaxChipBits = 16; ///< width of the chip index of the digits
+
+  static constexpr int MaxNChips = 1 << MaxChipBits;
+
+  DigitSorter() { setNChips(MaxNChips); }
+
+  /// size the chip field of the key for n chips; false if the chip indices
+  /// do not fit in the widest chip field
+  bool setNChips(int n)
+  {
+    if (n <= 0 || n > MaxNChips) {
+      return false;
+    }
+    mNChips = n;
+    mChipBits = 0;
+    while ((1 << mChipBits) < n) {
+      mChipBits++;
+    }
+    mROFShift = RowBits + ColBits + mChipBits;
+    return true;
+  }
+  int getNChips() const { return mNChips; }
+  int getChipBits() const { return mChipBits; }
+  /// digits of later RO frames do not fit in the key and are dropped
+  uint64_t getMaxNROFs() const { return uint64_t(1) << (64 - mROFShift); }
+
+  /// validate and sort one block of digits and their labels in place
+  void process(std::vector<o2::ITSMFT::Digit>& digits, Labels& labels, DigitSorterStats& stats) const;
+
+  /// validate and sort several blocks (tree entries) in parallel, then
+  /// concatenate them in a single ordered vector
+  void process(std::vector<std::vector<o2::ITSMFT::Digit>>& blocks, std::vector<Labels>& blockLabels,
+               std::vector<o2::ITSMFT::Digit>& digits, Labels& labels, DigitSorterStats& stats, int nThreads) const;
+
+  /// point the RO frame records to the sorted digits of their RO frame, a
+  /// single block (event 0), the records of RO frames without digits are empty
+  static void fillROFRecords(const std::vector<o2::ITSMFT::Digit>& digits, std::vector<o2::ITSMFT::ROFRecord>& rofs);
+
+  uint64_t getKey(const o2::ITSMFT::Digit& d) const
+  {
+    return (uint64_t(d.getROFrame()) << mROFShift) | (uint64_t(d.getChipIndex()) << (ColBits + RowBits)) |
+           (uint64_t(d.getColumn()) << RowBits) | d.getRow();
+  }
+
+ private:
+  static void radixSort(std::vector<uint64_t>& keys, std::vector<int>& order);
+
+  int mNChips = 0;
+  int mChipBits = 0;
+  int mROFShift = 0;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_DIGITSORTER */
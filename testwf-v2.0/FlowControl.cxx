@@ -0,0 +1,100 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   FlowControl.cxx
+
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "MFTTestwf/FlowControl.h"
+
+#include "FairLogger.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+std::string FlowControl::getId(const std::string& id, const std::string& prefix)
+{
+  return id.empty() ? prefix + "-" + std::to_string(::getppid()) : id;
+}
+
+bool FlowControl::open(const std::string& id, bool reset)
+{
+  close();
+  mName = "/" + id;
+  int fd = shm_open(mName.c_str(), O_CREAT | O_RDWR, 0600);
+  if (fd < 0) {
+    LOG(ERROR) << "Cannot open the flow control block " << mName.c_str() << " !";
+    return false;
+  }
+  // a new block is zero-filled
+  if (ftruncate(fd, sizeof(Block)) != 0) {
+    LOG(ERROR) << "Cannot size the flow control block " << mName.c_str() << " !";
+    ::close(fd);
+    return false;
+  }
+  void* addr = mmap(nullptr, sizeof(Block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "Cannot map the flow control block " << mName.c_str() << " !";
+    return false;
+  }
+  mBlock = static_cast<Block*>(addr);
+  if (reset) {
+    mBlock->nAcknowledged = 0;
+  }
+  return true;
+}
+
+void FlowControl::close()
+{
+  if (mBlock) {
+    munmap(mBlock, sizeof(Block));
+    mBlock = nullptr;
+  }
+}
+
+void FlowControl::unlink()
+{
+  if (!mName.empty()) {
+    shm_unlink(mName.c_str());
+  }
+}
+
+void FlowControl::acknowledge(uint32_t tfID)
+{
+  if (!mBlock) {
+    return;
+  }
+  auto n = mBlock->nAcknowledged.load();
+  while (n < tfID + 1 && !mBlock->nAcknowledged.compare_exchange_weak(n, tfID + 1)) {
+  }
+}
+
+double FlowControl::waitForCredit(uint32_t tfID, uint32_t maxInFlight) const
+{
+  if (!mBlock || tfID < getNAcknowledged() + maxInFlight) {
+    return 0.;
+  }
+  auto start = std::chrono::steady_clock::now();
+  while (tfID >= getNAcknowledged() + maxInFlight) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace MFT
+} // namespace o2
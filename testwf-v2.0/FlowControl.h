@@ -0,0 +1,68 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   FlowControl.h
+
+#ifndef O2_MFT_FLOWCONTROL_H_
+#define O2_MFT_FLOWCONTROL_H_
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace o2
+{
+namespace MFT
+{
+
+/// credit-based flow control between the digit readers and the cluster writer:
+/// the workflow has no channel going back upstream, the number of timeframes
+/// written is kept in a small shared memory block instead; a reader waits
+/// before sending the timeframe n until the timeframe n - K is written
+class FlowControl
+{
+ public:
+  FlowControl() = default;
+  ~FlowControl() { close(); }
+  FlowControl(const FlowControl&) = delete;
+  FlowControl& operator=(const FlowControl&) = delete;
+
+  /// map the shared block named after id, creating it if needed,
+  /// and reset the counter if reset is set
+  bool open(const std::string& id, bool reset);
+  /// id of the block: the given one, or if empty the prefix followed by the
+  /// pid of the parent process, the DPL driver which forked all the devices
+  /// of the workflow, so that concurrent workflows get their own blocks
+  static std::string getId(const std::string& id, const std::string& prefix);
+  void close();
+  bool isOpen() const { return mBlock != nullptr; }
+  /// remove the name of the shared block, the mappings stay valid
+  void unlink();
+
+  /// mark the timeframes up to tfID as written
+  void acknowledge(uint32_t tfID);
+  uint32_t getNAcknowledged() const { return mBlock ? mBlock->nAcknowledged.load() : 0; }
+
+  /// wait until the timeframe tfID can be sent with at most maxInFlight
+  /// timeframes not yet written, return the time waited in seconds
+  double waitForCredit(uint32_t tfID, uint32_t maxInFlight) const;
+
+ private:
+  struct Block {
+    std::atomic<uint32_t> nAcknowledged; ///< number of timeframes written
+  };
+  Block* mBlock = nullptr;
+  std::string mName;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_FLOWCONTROL */
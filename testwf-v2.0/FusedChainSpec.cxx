@@ -0,0 +1,181 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   FusedChainSpec.cxx
+
+#include <vector>
+
+#include "MFTTestwf/FusedChainSpec.h"
+#include "MFTTestwf/DigitSorter.h"
+
+#include "Framework/ControlService.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+FusedChain::FusedChain(bool withReader, bool withWriter, bool useNoiseFilter, bool usePacked)
+{
+  // the digits never leave the process when the reader is part of the chain,
+  // packing them would only cost time
+  if (withReader) {
+    mReader = std::make_unique<DigitReader<>>(false);
+    if (useNoiseFilter) {
+      mFilter = std::make_unique<NoisyPixelFilter>(false);
+    }
+  }
+  mClusterer = std::make_unique<ClustererDPL<>>(usePacked && !withReader);
+  if (withWriter) {
+    mWriter = std::make_unique<ClusterWriter<>>();
+  }
+}
+
+void FusedChain::init(InitContext& ic)
+{
+  // the chain runs only if all its devices are ready, their init logs why not
+  if (mReader) {
+    mReader->init(ic);
+    if (!mReader->isReady()) {
+      LOG(ERROR) << "MFTFusedChain: the digit reader cannot start !";
+      return;
+    }
+  }
+  if (mFilter) {
+    mFilter->init(ic);
+    if (!mFilter->isReady()) {
+      LOG(ERROR) << "MFTFusedChain: the noisy pixel filter cannot start !";
+      return;
+    }
+  }
+  mClusterer->init(ic);
+  if (!mClusterer->isReady()) {
+    LOG(ERROR) << "MFTFusedChain: the clusterer cannot start !";
+    return;
+  }
+  if (mWriter) {
+    mWriter->init(ic);
+    if (!mWriter->isReady()) {
+      LOG(ERROR) << "MFTFusedChain: the cluster writer cannot start !";
+      return;
+    }
+  }
+  mState = 1;
+}
+
+void FusedChain::run(ProcessingContext& pc)
+{
+  if (mState != 1)
+    return;
+
+  auto& clusters = mClusterer->getTimeframe();
+  if (mReader && mReader->isDone()) {
+    // resumed after the last timeframe
+    mState = 2;
+    pc.services().get<ControlService>().readyToQuit(true);
+    return;
+  }
+  if (mReader) {
+    auto& digits = mDigits;
+    if (!mReader->read(digits)) {
+      return;
+    }
+    LOG(INFO) << "MFTFusedChain read " << digits.digits.size() << " digits, in "
+              << digits.rofs.size() << " RO frames and "
+              << digits.mc2rofs.size() << " MC events";
+    if (mFilter) {
+      auto nMasked = mFilter->process(digits.digits, &digits.labels, digits.rofs.size(), mFiltered, mFilteredLabels);
+      LOG(INFO) << "MFTFusedChain masked " << nMasked << " noisy digits";
+      digits.digits.swap(mFiltered);
+      digits.labels.swap(mFilteredLabels);
+      DigitSorter::fillROFRecords(digits.digits, digits.rofs);
+    }
+    mDigitReader.setDigits(&digits.digits);
+    mDigitReader.setDigitsMCTruth(&digits.labels);
+    mDigitReader.init();
+    clusters.info = digits.info;
+    mClusterer->process(mDigitReader, digits.mc2rofs, clusters);
+  } else {
+    mClusterer->process(pc, clusters);
+  }
+
+  if (mWriter) {
+    mClusterer->transform(clusters);
+    mWriter->write(clusters);
+  } else {
+    mClusterer->send(pc, clusters);
+  }
+
+  // without the writer, the cluster writer downstream quits the workflow
+  if (clusters.info.isLast()) {
+    mState = 2;
+    if (mWriter) {
+      pc.services().get<ControlService>().readyToQuit(true);
+    } else if (mReader) {
+      pc.services().get<ControlService>().readyToQuit(false);
+    }
+  }
+}
+
+namespace
+{
+void addOptions(std::vector<ConfigParamSpec>& options, const std::vector<ConfigParamSpec>& more)
+{
+  for (const auto& opt : more) {
+    bool known = false;
+    for (const auto& o : options) {
+      known |= (o.name == opt.name);
+    }
+    if (!known) {
+      options.push_back(opt);
+    }
+  }
+}
+} // namespace
+
+DataProcessorSpec getFusedChainSpec(const std::string& chain, bool useNoiseFilter, bool usePacked)
+{
+  bool withReader = chain.find("reader") != std::string::npos;
+  bool withWriter = chain.find("writer") != std::string::npos;
+
+  // the inputs, outputs and options are those of the devices at the two
+  // ends of the chain, the options of all the devices are merged
+  auto clusterer = getClustererSpec(usePacked, (useNoiseFilter && !withReader) ? 1 : 0);
+  std::vector<InputSpec> inputs;
+  std::vector<OutputSpec> outputs;
+  std::vector<ConfigParamSpec> options;
+  if (withReader) {
+    addOptions(options, getDigitReaderSpec().options);
+    if (useNoiseFilter) {
+      addOptions(options, getNoisyPixelFilterSpec().options);
+    }
+  } else {
+    inputs = clusterer.inputs;
+  }
+  addOptions(options, clusterer.options);
+  if (withWriter) {
+    addOptions(options, getClusterWriterSpec().options);
+  } else {
+    outputs = clusterer.outputs;
+  }
+
+  return DataProcessorSpec{
+    "mft-" + chain,
+    inputs,
+    outputs,
+    AlgorithmSpec{ adaptFromTask<FusedChain>(withReader, withWriter, useNoiseFilter, usePacked) },
+    options
+  };
+}
+
+} // namespace MFT
+} // namespace o2
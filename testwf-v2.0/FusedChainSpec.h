@@ -0,0 +1,67 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   FusedChainSpec.h
+
+#ifndef O2_MFT_FUSEDCHAIN_H_
+#define O2_MFT_FUSEDCHAIN_H_
+
+#include <string>
+
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/Task.h"
+
+#include "MFTTestwf/DigitReaderSpec.h"
+#include "MFTTestwf/NoisyPixelFilterSpec.h"
+#include "MFTTestwf/ClustererSpec.h"
+#include "MFTTestwf/ClusterWriterSpec.h"
+
+#include "ITSMFTReconstruction/DigitPixelReader.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+/// run a chain of devices (reader, noise filter, clusterer, writer) in a
+/// single process: the data are handed over as in-memory objects
+class FusedChain : public Task
+{
+ public:
+  FusedChain(bool withReader, bool withWriter, bool useNoiseFilter, bool usePacked);
+  ~FusedChain() = default;
+  void init(InitContext& ic) final;
+  void run(ProcessingContext& pc) final;
+
+ private:
+  int mState = 0;
+  std::unique_ptr<DigitReader<>> mReader = nullptr;
+  std::unique_ptr<NoisyPixelFilter> mFilter = nullptr;
+  std::unique_ptr<ClustererDPL<>> mClusterer = nullptr;
+  std::unique_ptr<ClusterWriter<>> mWriter = nullptr;
+  // working buffers of the fused reader, reused across timeframes
+  DigitsTF mDigits;
+  std::vector<o2::ITSMFT::Digit> mFiltered;
+  NoisyPixelFilter::Labels mFilteredLabels;
+  o2::ITSMFT::DigitPixelReader mDigitReader;
+};
+
+/// create a processor spec
+/// run the MFT clusterer fused with the digit reader (and the noise filter)
+/// and/or with the cluster writer, chain is one of "reader-clusterer-writer",
+/// "reader-clusterer" or "clusterer-writer"
+framework::DataProcessorSpec getFusedChainSpec(const std::string& chain, bool useNoiseFilter = false, bool usePacked = false);
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_FUSEDCHAIN */
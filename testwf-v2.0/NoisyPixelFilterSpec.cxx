@@ -0,0 +1,262 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   NoisyPixelFilterSpec.cxx
+
+#include <fstream>
+#include <sstream>
+
+#include "MFTTestwf/NoisyPixelFilterSpec.h"
+#include "MFTTestwf/PackedDigits.h"
+#include "MFTTestwf/DigitSorter.h"
+
+#include "Framework/ControlService.h"
+#include "DataFormatsITSMFT/ROFRecord.h"
+
+using namespace o2::framework;
+using namespace o2::ITSMFT;
+
+namespace o2
+{
+namespace MFT
+{
+
+void NoisyPixelMask::setNoisy(int chip, int row, int col)
+{
+  auto& words = mChips[chip];
+  if (words.empty()) {
+    words.resize(NWords, 0);
+  }
+  int id = row * NCols + col;
+  words[id >> 6] |= uint64_t(1) << (id & 63);
+}
+
+size_t NoisyPixelMask::getNNoisy() const
+{
+  size_t n = 0;
+  for (const auto& words : mChips) {
+    for (auto w : words) {
+      n += __builtin_popcountll(w);
+    }
+  }
+  return n;
+}
+
+size_t NoisyPixelMask::filter(const std::vector<Digit>& digits, const Labels* labels,
+                              std::vector<Digit>& outDigits, Labels* outLabels) const
+{
+  outDigits.clear();
+  outDigits.reserve(digits.size());
+  if (outLabels) {
+    outLabels->clear();
+  }
+
+  // the mask of the current chip is looked up only when the chip changes,
+  // the digits of clean chips are copied without any bit test
+  int lastChip = -1;
+  const uint64_t* words = nullptr;
+  for (size_t i = 0; i < digits.size(); i++) {
+    const auto& d = digits[i];
+    if (d.getChipIndex() != lastChip) {
+      lastChip = d.getChipIndex();
+      words = getChipWords(lastChip);
+    }
+    if (words) {
+      int id = d.getRow() * NCols + d.getColumn();
+      if ((words[id >> 6] >> (id & 63)) & 1) {
+        continue;
+      }
+    }
+    if (labels && outLabels) {
+      auto iout = outDigits.size();
+      for (const auto& lab : labels->getLabels(i)) {
+        outLabels->addElement(iout, lab);
+      }
+    }
+    outDigits.push_back(d);
+  }
+  return digits.size() - outDigits.size();
+}
+
+bool NoisyPixelMask::readFile(const std::string& filename)
+{
+  std::ifstream in(filename);
+  if (!in.good()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream iss(line);
+    int chip, row, col;
+    if (!(iss >> chip >> row >> col)) {
+      continue;
+    }
+    if (chip < 0 || chip >= getNChips() || row < 0 || row >= NRows || col < 0 || col >= NCols) {
+      LOG(WARNING) << "Ignoring the noisy pixel with chip " << chip << " row " << row << " column " << col;
+      continue;
+    }
+    setNoisy(chip, row, col);
+  }
+  return true;
+}
+
+bool NoisyPixelMask::writeFile(const std::string& filename) const
+{
+  std::ofstream out(filename);
+  if (!out.good()) {
+    return false;
+  }
+  out << "# chip row column\n";
+  for (int chip = 0; chip < getNChips(); chip++) {
+    const auto& words = mChips[chip];
+    for (int iw = 0; iw < int(words.size()); iw++) {
+      for (auto w = words[iw]; w; w &= w - 1) {
+        int id = (iw << 6) + __builtin_ctzll(w);
+        out << chip << ' ' << id / NCols << ' ' << id % NCols << '\n';
+      }
+    }
+  }
+  return true;
+}
+
+void NoisyPixelFilter::init(InitContext& ic)
+{
+  mMask.setNChips(ic.options().get<int>("mft-nchips"));
+  mLearnTFs = ic.options().get<int>("mft-noise-learn-tfs");
+  mThreshold = ic.options().get<float>("mft-noise-threshold");
+  mOutFileName = ic.options().get<std::string>("mft-noise-outfile");
+  mChannelStats.setEnabled(ic.options().get<bool>("mft-channel-stats"));
+
+  if (mLearnTFs > 0) {
+    LOG(INFO) << "MFTNoisyPixelFilter learns the noisy pixels over " << mLearnTFs
+              << " TFs, with a threshold of " << mThreshold << " hits per RO frame";
+  } else {
+    auto filename = ic.options().get<std::string>("mft-noise-infile");
+    if (!mMask.readFile(filename)) {
+      LOG(ERROR) << "Cannot open the " << filename.c_str() << " file !";
+      mState = 0;
+      return;
+    }
+    LOG(INFO) << "MFTNoisyPixelFilter masks " << mMask.getNNoisy() << " noisy pixels from " << filename.c_str();
+  }
+  mState = 1;
+}
+
+void NoisyPixelFilter::learn(const std::vector<Digit>& digits, size_t nROFs)
+{
+  for (const auto& d : digits) {
+    if (d.getChipIndex() >= mMask.getNChips()) {
+      continue;
+    }
+    uint32_t key = (uint32_t(d.getChipIndex()) * NoisyPixelMask::NRows + d.getRow()) * NoisyPixelMask::NCols + d.getColumn();
+    mPixelCounts[key]++;
+  }
+  mLearnROFs += nROFs;
+
+  if (mNTFs < mLearnTFs) {
+    return;
+  }
+  auto minCount = mThreshold * mLearnROFs;
+  for (const auto& pix : mPixelCounts) {
+    if (pix.second > minCount) {
+      auto id = pix.first % (NoisyPixelMask::NRows * NoisyPixelMask::NCols);
+      mMask.setNoisy(pix.first / (NoisyPixelMask::NRows * NoisyPixelMask::NCols), id / NoisyPixelMask::NCols, id % NoisyPixelMask::NCols);
+    }
+  }
+  mPixelCounts.clear();
+  LOG(INFO) << "MFTNoisyPixelFilter learned " << mMask.getNNoisy() << " noisy pixels in "
+            << mLearnROFs << " RO frames";
+  if (!mOutFileName.empty() && !mMask.writeFile(mOutFileName)) {
+    LOG(ERROR) << "Cannot open the " << mOutFileName.c_str() << " file !";
+  }
+}
+
+size_t NoisyPixelFilter::process(const std::vector<Digit>& digits, const Labels* labels, size_t nROFs,
+                                 std::vector<Digit>& outDigits, Labels& outLabels)
+{
+  mNTFs++;
+  if (mNTFs <= mLearnTFs) {
+    learn(digits, nROFs);
+  }
+  return mMask.filter(digits, labels, outDigits, &outLabels);
+}
+
+void NoisyPixelFilter::send(ProcessingContext& pc, std::vector<Digit>& digits, Labels& labels,
+                            const std::vector<ROFRecord>& rofs)
+{
+  if (mUsePacked) {
+    sendPackedDigits(pc.outputs(), 1, digits, labels);
+  } else {
+    pc.outputs().snapshot(Output{ "MFT", "DIGITS", 1, Lifetime::Timeframe }, digits);
+  }
+  pc.outputs().snapshot(Output{ "MFT", "DIGITSMCTR", 1, Lifetime::Timeframe }, labels);
+  pc.outputs().snapshot(Output{ "MFT", "MFTDigitROF", 1, Lifetime::Timeframe }, rofs);
+}
+
+void NoisyPixelFilter::run(ProcessingContext& pc)
+{
+  if (mState != 1)
+    return;
+
+  auto digits = pc.inputs().get<const std::vector<o2::ITSMFT::Digit>>("digits");
+  auto labels = pc.inputs().get<const o2::dataformats::MCTruthContainer<o2::MCCompLabel>*>("labels");
+  auto rofs = pc.inputs().get<const std::vector<o2::ITSMFT::ROFRecord>>("ROframes");
+  mChannelStats.account(pc.inputs());
+
+  std::vector<o2::ITSMFT::Digit> outDigits;
+  Labels outLabels;
+  auto nMasked = process(digits, labels.get(), rofs.size(), outDigits, outLabels);
+  // the records point to the surviving digits, which keep their RO frame order
+  std::vector<o2::ITSMFT::ROFRecord> outROFs(rofs.begin(), rofs.end());
+  DigitSorter::fillROFRecords(outDigits, outROFs);
+
+  LOG(INFO) << "MFTNoisyPixelFilter pushed " << outDigits.size() << " digits, masked "
+            << nMasked << " noisy digits";
+
+  send(pc, outDigits, outLabels, outROFs);
+  mChannelStats.print("MFTNoisyPixelFilter");
+}
+
+DataProcessorSpec getNoisyPixelFilterSpec(bool usePacked)
+{
+  std::vector<OutputSpec> outputs;
+  if (usePacked) {
+    outputs.emplace_back("MFT", "PDIGROW", 1, Lifetime::Timeframe);
+    outputs.emplace_back("MFT", "PDIGCOL", 1, Lifetime::Timeframe);
+    outputs.emplace_back("MFT", "PDIGCHIP", 1, Lifetime::Timeframe);
+  } else {
+    outputs.emplace_back("MFT", "DIGITS", 1, Lifetime::Timeframe);
+  }
+  outputs.emplace_back("MFT", "DIGITSMCTR", 1, Lifetime::Timeframe);
+  outputs.emplace_back("MFT", "MFTDigitROF", 1, Lifetime::Timeframe);
+
+  return DataProcessorSpec{
+    "mft-noise-filter",
+    Inputs{
+      InputSpec{ "digits", "MFT", "DIGITS", 0, Lifetime::Timeframe },
+      InputSpec{ "labels", "MFT", "DIGITSMCTR", 0, Lifetime::Timeframe },
+      InputSpec{ "ROframes", "MFT", "MFTDigitROF", 0, Lifetime::Timeframe } },
+    outputs,
+    AlgorithmSpec{ adaptFromTask<NoisyPixelFilter>(usePacked) },
+    Options{
+      { "mft-noise-infile", VariantType::String, "mft_noisy_pixels.txt", { "Name of the noisy pixels file" } },
+      { "mft-noise-outfile", VariantType::String, "", { "Name of the file where to save the learned noisy pixels" } },
+      { "mft-noise-learn-tfs", VariantType::Int, 0, { "Learn the noisy pixels over this number of TFs instead of reading them" } },
+      { "mft-noise-threshold", VariantType::Float, 0.01f, { "Minimum number of hits per RO frame of a noisy pixel" } },
+      { "mft-nchips", VariantType::Int, o2::ITSMFT::ChipMappingMFT::getNChips(), { "Number of chips" } },
+      { "mft-channel-stats", VariantType::Bool, false, { "Report the bytes received per input route" } } }
+  };
+}
+
+} // namespace MFT
+} // namespace o2
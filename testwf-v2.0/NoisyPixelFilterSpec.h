@@ -0,0 +1,116 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   NoisyPixelFilterSpec.h
+
+#ifndef O2_MFT_NOISYPIXELFILTER_H_
+#define O2_MFT_NOISYPIXELFILTER_H_
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/Task.h"
+
+#include "MFTTestwf/ChannelStats.h"
+
+#include "ITSMFTBase/Digit.h"
+#include "ITSMFTBase/SegmentationAlpide.h"
+#include "ITSMFTReconstruction/ChipMappingMFT.h"
+#include "DataFormatsITSMFT/ROFRecord.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+
+using namespace o2::framework;
+
+namespace o2
+{
+namespace MFT
+{
+
+/// per-chip bitmask of the noisy pixels, one bit per pixel, allocated
+/// only for the chips which have at least one noisy pixel
+class NoisyPixelMask
+{
+ public:
+  using Labels = o2::dataformats::MCTruthContainer<o2::MCCompLabel>;
+
+  static constexpr int NRows = o2::ITSMFT::SegmentationAlpide::NRows;
+  static constexpr int NCols = o2::ITSMFT::SegmentationAlpide::NCols;
+  static constexpr int NWords = NRows * NCols / 64;
+
+  void setNChips(int n) { mChips.assign(n, std::vector<uint64_t>()); }
+  int getNChips() const { return mChips.size(); }
+
+  void setNoisy(int chip, int row, int col);
+  size_t getNNoisy() const;
+  const uint64_t* getChipWords(int chip) const
+  {
+    return (chip < int(mChips.size()) && !mChips[chip].empty()) ? mChips[chip].data() : nullptr;
+  }
+
+  /// copy the digits not masked, and their labels
+  size_t filter(const std::vector<o2::ITSMFT::Digit>& digits, const Labels* labels,
+                std::vector<o2::ITSMFT::Digit>& outDigits, Labels* outLabels) const;
+
+  /// text file, one noisy pixel "chip row column" per line
+  bool readFile(const std::string& filename);
+  bool writeFile(const std::string& filename) const;
+
+ private:
+  std::vector<std::vector<uint64_t>> mChips;
+};
+
+class NoisyPixelFilter : public Task
+{
+ public:
+  using Labels = o2::dataformats::MCTruthContainer<o2::MCCompLabel>;
+
+  NoisyPixelFilter(bool usePacked) : mUsePacked(usePacked) {}
+  ~NoisyPixelFilter() = default;
+  void init(InitContext& ic) final;
+  void run(ProcessingContext& pc) final;
+
+  /// learn and apply the mask, returns the number of masked digits
+  size_t process(const std::vector<o2::ITSMFT::Digit>& digits, const Labels* labels, size_t nROFs,
+                 std::vector<o2::ITSMFT::Digit>& outDigits, Labels& outLabels);
+  /// false until init succeeded
+  bool isReady() const { return mState != 0; }
+  /// send the surviving digits as messages, with the RO frame records pointing to them
+  void send(ProcessingContext& pc, std::vector<o2::ITSMFT::Digit>& digits, Labels& labels,
+            const std::vector<o2::ITSMFT::ROFRecord>& rofs);
+
+ private:
+  void learn(const std::vector<o2::ITSMFT::Digit>& digits, size_t nROFs);
+
+  int mState = 0;
+  bool mUsePacked = false;
+  int mLearnTFs = 0;         // number of TFs used to learn the mask, 0 if read from file
+  int mNTFs = 0;             // number of TFs seen
+  float mThreshold = 0.;     // minimum firing probability per RO frame of a noisy pixel
+  size_t mLearnROFs = 0;     // number of RO frames seen while learning
+  std::string mOutFileName;
+  std::unordered_map<uint32_t, uint32_t> mPixelCounts;
+  NoisyPixelMask mMask;
+  ChannelStats mChannelStats;
+};
+
+/// create a processor spec
+/// remove the MFT digits of noisy pixels before clustering; the surviving
+/// digits, labels and RO frame records are sent with subSpec 1 (packed if
+/// usePacked is set)
+framework::DataProcessorSpec getNoisyPixelFilterSpec(bool usePacked = false);
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_NOISYPIXELFILTER */
@@ -6,6 +6,7 @@ o2_define_bucket(
     #
     Framework
     MFTBase
+    ITSBase
     ITSMFTBase
     ITSMFTReconstruction
     DataFormatsITSMFT
@@ -13,3 +14,26 @@ o2_define_bucket(
     INCLUDE_DIRECTORIES
 )
 
+
+o2_define_bucket(
+    NAME
+    mft_testwf_tools_bucket
+
+    DEPENDENCIES
+    #
+    common_boost_bucket
+    Headers
+    DetectorsBase
+    MathUtils
+    SimulationDataFormat
+    DataFormatsITSMFT
+    ITSMFTBase
+    ITSMFTSimulation
+    ITSMFTReconstruction
+    ITSBase
+    MFTBase
+    ITSReconstruction
+    MFTReconstruction
+
+    INCLUDE_DIRECTORIES
+)
@@ -0,0 +1,191 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   PackedDigits.cxx
+
+#include <algorithm>
+#include <numeric>
+
+#include "MFTTestwf/PackedDigits.h"
+
+using namespace o2::ITSMFT;
+
+namespace o2
+{
+namespace MFT
+{
+
+namespace
+{
+inline uint64_t chipKey(const Digit& d)
+{
+  return (uint64_t(d.getROFrame()) << 16) | d.getChipIndex();
+}
+} // namespace
+
+void PackedDigits::clear()
+{
+  mRows.clear();
+  mCols.clear();
+  mChips.clear();
+}
+
+bool PackedDigits::fillRecords(const std::vector<Digit>& digits, std::vector<int>& order)
+{
+  clear();
+  order.clear();
+
+  bool grouped = std::is_sorted(digits.begin(), digits.end(),
+                                [](const Digit& a, const Digit& b) { return chipKey(a) < chipKey(b); });
+  if (!grouped) {
+    order.resize(digits.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&digits](int a, int b) { return chipKey(digits[a]) < chipKey(digits[b]); });
+  }
+
+  uint64_t lastKey = ~uint64_t(0);
+  for (size_t i = 0; i < digits.size(); i++) {
+    const auto& d = digits[grouped ? i : order[i]];
+    auto key = chipKey(d);
+    if (key != lastKey) {
+      PackedChipRecord rec;
+      rec.roFrame = d.getROFrame();
+      rec.firstEntry = i;
+      rec.chipID = d.getChipIndex();
+      mChips.push_back(rec);
+      lastKey = key;
+    }
+    mChips.back().nEntries++;
+  }
+
+  return !grouped;
+}
+
+void PackedDigits::fillColumns(const std::vector<Digit>& digits, const std::vector<int>& order,
+                               gsl::span<uint16_t> rows, gsl::span<uint16_t> cols)
+{
+  if (order.empty()) {
+    for (size_t i = 0; i < digits.size(); i++) {
+      rows[i] = digits[i].getRow();
+      cols[i] = digits[i].getColumn();
+    }
+  } else {
+    for (size_t i = 0; i < digits.size(); i++) {
+      const auto& d = digits[order[i]];
+      rows[i] = d.getRow();
+      cols[i] = d.getColumn();
+    }
+  }
+}
+
+bool PackedDigits::fill(const std::vector<Digit>& digits, std::vector<int>& order)
+{
+  bool reordered = fillRecords(digits, order);
+  mRows.resize(digits.size());
+  mCols.resize(digits.size());
+  fillColumns(digits, order, gsl::span<uint16_t>(mRows), gsl::span<uint16_t>(mCols));
+  return reordered;
+}
+
+void PackedDigits::reorderLabels(const Labels& src, const std::vector<int>& order, Labels& dst)
+{
+  dst.clear();
+  for (size_t i = 0; i < order.size(); i++) {
+    for (const auto& lab : src.getLabels(order[i])) {
+      dst.addElement(i, lab);
+    }
+  }
+}
+
+void sendPackedDigits(o2::framework::DataAllocator& outputs, int subSpec,
+                      const std::vector<Digit>& digits, PackedDigits::Labels& labels,
+                      o2::header::DataOrigin origin)
+{
+  using o2::framework::Output;
+  using o2::framework::Lifetime;
+
+  PackedDigits packed;
+  std::vector<int> order;
+  if (packed.fillRecords(digits, order)) {
+    PackedDigits::Labels packedLabels;
+    PackedDigits::reorderLabels(labels, order, packedLabels);
+    labels.swap(packedLabels);
+  }
+  // the row/column columns are written directly in the output messages,
+  // which live in the shared memory segment with the shmem transport
+  auto rows = outputs.make<uint16_t>(Output{ origin, "PDIGROW", subSpec, Lifetime::Timeframe }, digits.size());
+  auto cols = outputs.make<uint16_t>(Output{ origin, "PDIGCOL", subSpec, Lifetime::Timeframe }, digits.size());
+  PackedDigits::fillColumns(digits, order, rows, cols);
+  outputs.snapshot(Output{ origin, "PDIGCHIP", subSpec, Lifetime::Timeframe }, packed.mChips);
+}
+
+bool PackedDigitPixelReader::getNextChipData(ChipPixelData& chipData)
+{
+  if (mIdChip >= mChips.size()) {
+    return false;
+  }
+  const auto& rec = mChips[mIdChip++];
+  chipData.clear();
+  chipData.setChipID(rec.chipID);
+  chipData.setROFrame(rec.roFrame);
+  chipData.setStartID(rec.firstEntry);
+  auto& pixels = chipData.getData();
+  pixels.reserve(rec.nEntries);
+  const auto* rows = mRows.data() + rec.firstEntry;
+  const auto* cols = mCols.data() + rec.firstEntry;
+  for (uint32_t i = 0; i < rec.nEntries; i++) {
+    pixels.emplace_back(rows[i], cols[i]);
+  }
+  return true;
+}
+
+ChipPixelData* PackedDigitPixelReader::getNextChipData(std::vector<ChipPixelData>& chipDataVec)
+{
+  if (mIdChip >= mChips.size()) {
+    return nullptr;
+  }
+  auto& chipData = chipDataVec[mChips[mIdChip].chipID];
+  return getNextChipData(chipData) ? &chipData : nullptr;
+}
+
+bool DigitSpanPixelReader::getNextChipData(ChipPixelData& chipData)
+{
+  if (mIdDig >= size_t(mDigits.size())) {
+    return false;
+  }
+  auto chipID = mDigits[mIdDig].getChipIndex();
+  auto roFrame = mDigits[mIdDig].getROFrame();
+  chipData.clear();
+  chipData.setChipID(chipID);
+  chipData.setROFrame(roFrame);
+  chipData.setStartID(mIdDig);
+  auto& pixels = chipData.getData();
+  for (; mIdDig < size_t(mDigits.size()); mIdDig++) {
+    const auto& d = mDigits[mIdDig];
+    if (d.getChipIndex() != chipID || d.getROFrame() != roFrame) {
+      break;
+    }
+    pixels.emplace_back(d.getRow(), d.getColumn());
+  }
+  return true;
+}
+
+ChipPixelData* DigitSpanPixelReader::getNextChipData(std::vector<ChipPixelData>& chipDataVec)
+{
+  if (mIdDig >= size_t(mDigits.size())) {
+    return nullptr;
+  }
+  auto& chipData = chipDataVec[mDigits[mIdDig].getChipIndex()];
+  return getNextChipData(chipData) ? &chipData : nullptr;
+}
+
+} // namespace MFT
+} // namespace o2
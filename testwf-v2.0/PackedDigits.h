@@ -0,0 +1,142 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   PackedDigits.h
+
+#ifndef O2_MFT_PACKEDDIGITS_H_
+#define O2_MFT_PACKEDDIGITS_H_
+
+#include <vector>
+#include <cstdint>
+
+#include <gsl/span>
+
+#include "Framework/DataAllocator.h"
+#include "Headers/DataHeader.h"
+#include "ITSMFTBase/Digit.h"
+#include "ITSMFTReconstruction/PixelReader.h"
+#include "ITSMFTReconstruction/PixelData.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// one record per fired chip in a RO frame, pointing to its pixels
+/// in the row/column columns of the packed digits
+struct PackedChipRecord {
+  uint32_t roFrame = 0;    ///< RO frame of the chip data
+  uint32_t firstEntry = 0; ///< index of the first pixel in the row/column arrays
+  uint32_t nEntries = 0;   ///< number of pixels fired in the chip
+  uint16_t chipID = 0;     ///< chip index
+  uint16_t reserved = 0;   ///< padding, keeps the record 16 bytes long
+};
+
+/// structure-of-arrays form of the digits, grouped by RO frame and chip:
+/// - rows, cols : 16-bit coordinates of the fired pixels
+/// - chips      : per-chip start offsets in rows/cols, with the RO frame of
+///                the chip; the RO frame records are sent as digit ROF records
+class PackedDigits
+{
+ public:
+  using Labels = o2::dataformats::MCTruthContainer<o2::MCCompLabel>;
+
+  void clear();
+
+  /// pack the digits, grouping them by RO frame and chip; when the input is not
+  /// already grouped, "order" is filled with the source index of each packed pixel
+  /// and true is returned
+  bool fill(const std::vector<o2::ITSMFT::Digit>& digits, std::vector<int>& order);
+
+  /// same as fill, without the row/column columns
+  bool fillRecords(const std::vector<o2::ITSMFT::Digit>& digits, std::vector<int>& order);
+
+  /// write the row/column columns in place, in the order returned by fillRecords
+  static void fillColumns(const std::vector<o2::ITSMFT::Digit>& digits, const std::vector<int>& order,
+                          gsl::span<uint16_t> rows, gsl::span<uint16_t> cols);
+
+  /// reorder the MC labels of the digits according to the order returned by fill
+  static void reorderLabels(const Labels& src, const std::vector<int>& order, Labels& dst);
+
+  size_t getNPixels() const { return mRows.size(); }
+
+  std::vector<uint16_t> mRows;
+  std::vector<uint16_t> mCols;
+  std::vector<PackedChipRecord> mChips;
+};
+
+/// pack the digits and send them with the given origin and subSpec, the labels
+/// are reordered to follow the packed digits
+void sendPackedDigits(o2::framework::DataAllocator& outputs, int subSpec,
+                      const std::vector<o2::ITSMFT::Digit>& digits, PackedDigits::Labels& labels,
+                      o2::header::DataOrigin origin = o2::header::gDataOriginMFT);
+
+/// PixelReader feeding the clusterer directly from the packed digits
+class PackedDigitPixelReader : public o2::ITSMFT::PixelReader
+{
+ public:
+  using Labels = o2::dataformats::MCTruthContainer<o2::MCCompLabel>;
+
+  PackedDigitPixelReader() = default;
+  ~PackedDigitPixelReader() override = default;
+
+  void setPackedDigits(gsl::span<const uint16_t> rows, gsl::span<const uint16_t> cols,
+                       gsl::span<const PackedChipRecord> chips)
+  {
+    mRows = rows;
+    mCols = cols;
+    mChips = chips;
+  }
+  void setDigitsMCTruth(const Labels* m) { mDigitsMCTruth = m; }
+  const Labels* getDigitsMCTruth() const override { return mDigitsMCTruth; }
+
+  void init() override { mIdChip = 0; }
+  bool getNextChipData(o2::ITSMFT::ChipPixelData& chipData) override;
+  o2::ITSMFT::ChipPixelData* getNextChipData(std::vector<o2::ITSMFT::ChipPixelData>& chipDataVec) override;
+
+ private:
+  gsl::span<const uint16_t> mRows;
+  gsl::span<const uint16_t> mCols;
+  gsl::span<const PackedChipRecord> mChips;
+  const Labels* mDigitsMCTruth = nullptr;
+  size_t mIdChip = 0;
+};
+
+/// PixelReader feeding the clusterer from the digits of a message, read in
+/// place instead of being copied into a vector; the digits come grouped by
+/// RO frame and chip
+class DigitSpanPixelReader : public o2::ITSMFT::PixelReader
+{
+ public:
+  using Labels = o2::dataformats::MCTruthContainer<o2::MCCompLabel>;
+
+  DigitSpanPixelReader() = default;
+  ~DigitSpanPixelReader() override = default;
+
+  void setDigits(gsl::span<const o2::ITSMFT::Digit> digits) { mDigits = digits; }
+  void setDigitsMCTruth(const Labels* m) { mDigitsMCTruth = m; }
+  const Labels* getDigitsMCTruth() const override { return mDigitsMCTruth; }
+
+  void init() override { mIdDig = 0; }
+  bool getNextChipData(o2::ITSMFT::ChipPixelData& chipData) override;
+  o2::ITSMFT::ChipPixelData* getNextChipData(std::vector<o2::ITSMFT::ChipPixelData>& chipDataVec) override;
+
+ private:
+  gsl::span<const o2::ITSMFT::Digit> mDigits;
+  const Labels* mDigitsMCTruth = nullptr;
+  size_t mIdDig = 0;
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_PACKEDDIGITS */
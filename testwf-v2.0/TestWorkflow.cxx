@@ -13,10 +13,14 @@
 #include "MFTTestwf/TestWorkflow.h"
 
 #include "MFTTestwf/DigitReaderSpec.h"
+#include "MFTTestwf/DigitMergerSpec.h"
 #include "MFTTestwf/DigitDigestSpec.h"
 #include "MFTTestwf/DigestWriterSpec.h"
+#include "MFTTestwf/NoisyPixelFilterSpec.h"
 #include "MFTTestwf/ClustererSpec.h"
 #include "MFTTestwf/ClusterWriterSpec.h"
+#include "MFTTestwf/FusedChainSpec.h"
+#include "MFTTestwf/DictionaryLearnerSpec.h"
 
 namespace o2
 {
@@ -26,16 +30,60 @@ namespace MFT
 namespace TestWorkflow
 {
 
-framework::WorkflowSpec getWorkflow()
+framework::WorkflowSpec getWorkflow(bool usePackedDigits, bool useNoiseFilter, const std::string& fusedChain, int nReaders,
+                                    bool learnDictionary)
 {
   framework::WorkflowSpec specs;
 
-  specs.emplace_back(o2::MFT::getDigitReaderSpec());
-  specs.emplace_back(o2::MFT::getDigitDigestSpec());
-  specs.emplace_back(o2::MFT::getDigestWriterSpec());
-  specs.emplace_back(o2::MFT::getClustererSpec());
-  specs.emplace_back(o2::MFT::getClusterWriterSpec());
+  // with the noise filter, the digits are packed after filtering and the
+  // clusterer takes them from the filter (subSpec 1)
+  int digitsSubSpec = useNoiseFilter ? 1 : 0;
 
+  bool fuseReader = fusedChain.find("reader") != std::string::npos;
+  bool fuseWriter = fusedChain.find("writer") != std::string::npos;
+
+  // when the reader is fused with the clusterer, the digits do not leave
+  // the process and there is nothing left for the digest
+  if (!fuseReader) {
+    // several readers send their files to the merger, which restores the
+    // order of the files and packs the digits if requested
+    bool packReader = usePackedDigits && !useNoiseFilter;
+    if (nReaders > 1) {
+      for (int i = 0; i < nReaders; i++) {
+        specs.emplace_back(o2::MFT::getDigitReaderSpec(false, i, nReaders));
+      }
+      specs.emplace_back(o2::MFT::getDigitMergerSpec(packReader, nReaders));
+    } else {
+      specs.emplace_back(o2::MFT::getDigitReaderSpec(packReader));
+    }
+    if (useNoiseFilter) {
+      specs.emplace_back(o2::MFT::getNoisyPixelFilterSpec(usePackedDigits));
+    }
+    specs.emplace_back(o2::MFT::getDigitDigestSpec(usePackedDigits, digitsSubSpec));
+    specs.emplace_back(o2::MFT::getDigestWriterSpec());
+  }
+  if (fusedChain.empty()) {
+    specs.emplace_back(o2::MFT::getClustererSpec(usePackedDigits, digitsSubSpec));
+  } else {
+    specs.emplace_back(o2::MFT::getFusedChainSpec(fusedChain, useNoiseFilter, usePackedDigits));
+  }
+  if (!fuseWriter) {
+    specs.emplace_back(o2::MFT::getClusterWriterSpec());
+    // the clusters do not leave a chain fused with the writer
+    if (learnDictionary) {
+      specs.emplace_back(o2::MFT::getDictionaryLearnerSpec());
+    }
+  }
+
+  return specs;
+}
+
+framework::WorkflowSpec getITSWorkflow(bool usePackedDigits)
+{
+  framework::WorkflowSpec specs;
+  specs.emplace_back(o2::MFT::getDigitReaderSpec<o2::ITSMFT::ChipMappingITS>(usePackedDigits));
+  specs.emplace_back(o2::MFT::getClustererSpec<o2::ITSMFT::ChipMappingITS>(usePackedDigits));
+  specs.emplace_back(o2::MFT::getClusterWriterSpec<o2::ITSMFT::ChipMappingITS>());
   return specs;
 }
 
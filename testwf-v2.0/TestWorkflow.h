@@ -0,0 +1,36 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef O2_MFT_TESTWORKFLOW_H_
+#define O2_MFT_TESTWORKFLOW_H_
+
+/// @file   TestWorkflow.h
+
+#include <string>
+
+#include "Framework/WorkflowSpec.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+namespace TestWorkflow
+{
+framework::WorkflowSpec getWorkflow(bool usePackedDigits = false, bool useNoiseFilter = false,
+                                    const std::string& fusedChain = "", int nReaders = 1,
+                                    bool learnDictionary = false);
+/// reader, clusterer and writer of the ITS, the same specs instantiated with ChipMappingITS
+framework::WorkflowSpec getITSWorkflow(bool usePackedDigits = false);
+}
+
+} // namespace MFT
+} // namespace o2
+#endif
@@ -0,0 +1,89 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   TimeframeData.h
+
+#ifndef O2_MFT_TIMEFRAMEDATA_H_
+#define O2_MFT_TIMEFRAMEDATA_H_
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "ITSMFTBase/Digit.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+#include "DataFormatsITSMFT/CompCluster.h"
+#include "DataFormatsITSMFT/Cluster.h"
+#include "DataFormatsITSMFT/ROFRecord.h"
+
+#include "MFTTestwf/ChipTransform.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// position of a timeframe in the run, sent along with the data (MFTDigitTFInfo,
+/// MFTClusterTFInfo) so that the terminal devices know when the last one is processed
+struct TimeframeInfo {
+  uint32_t tfID = 0;    ///< index of the timeframe
+  uint32_t nTFs = 0;    ///< number of timeframes in the run
+  uint32_t nextROF = 0; ///< first free RO frame after the timeframe, recorded at each checkpoint
+  uint32_t nReaders = 1; ///< number of digit readers sharing the input files, recorded at each checkpoint
+  bool hasGlobal = false; ///< the clusters come with their global positions, set by the clusterer
+  bool isLast() const { return tfID + 1 >= nTFs; }
+};
+
+/// in-memory content of a timeframe of digits, as handed over between
+/// the devices of a fused chain instead of being sent as messages
+struct DigitsTF {
+  TimeframeInfo info;
+  std::vector<o2::ITSMFT::Digit> digits;
+  o2::dataformats::MCTruthContainer<o2::MCCompLabel> labels;
+  std::vector<o2::ITSMFT::ROFRecord> rofs;
+  std::vector<o2::ITSMFT::MC2ROFRecord> mc2rofs;
+};
+
+/// shift the RO frames of the digits by offset, so that the RO frames of
+/// consecutive input files do not overlap; return the first free RO frame
+inline uint32_t shiftROFrames(DigitsTF& tf, uint32_t offset)
+{
+  uint32_t next = offset;
+  for (auto& d : tf.digits) {
+    d.setROFrame(d.getROFrame() + offset);
+    next = std::max(next, uint32_t(d.getROFrame() + 1));
+  }
+  for (auto& rof : tf.rofs) {
+    rof.setROFrame(rof.getROFrame() + offset);
+    next = std::max(next, uint32_t(rof.getROFrame() + 1));
+  }
+  for (auto& mc2rof : tf.mc2rofs) {
+    mc2rof.minROF += offset;
+    mc2rof.maxROF += offset;
+  }
+  return next;
+}
+
+/// in-memory content of a timeframe of clusters
+struct ClustersTF {
+  TimeframeInfo info;
+  std::vector<o2::ITSMFT::CompClusterExt> compClusters;
+  std::vector<o2::ITSMFT::Cluster> clusters;
+  o2::dataformats::MCTruthContainer<o2::MCCompLabel> labels;
+  std::vector<o2::ITSMFT::ROFRecord> rofs;
+  std::vector<o2::ITSMFT::MC2ROFRecord> mc2rofs;
+  ClusterCoordinates global; ///< global positions of the full clusters, if requested
+};
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_TIMEFRAMEDATA */
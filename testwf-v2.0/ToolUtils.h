@@ -0,0 +1,136 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   ToolUtils.h
+
+#ifndef O2_MFT_TOOLUTILS_H_
+#define O2_MFT_TOOLUTILS_H_
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "TApplication.h"
+#include "TROOT.h"
+
+#include "MFTTestwf/DetectorTraits.h"
+
+namespace o2
+{
+namespace MFT
+{
+
+/// command-line handling shared by the standalone tools (mft-check-clusters,
+/// mft-check-topologies, mft-read-digits, mft-clus-sa)
+namespace ToolUtils
+{
+
+/// parse the command line; false if the tool should exit, with exitCode set
+/// to 0 after --help and to 1 after an error
+inline bool parseOptions(int argc, char** argv, const boost::program_options::options_description& desc,
+                         boost::program_options::variables_map& vm, int& exitCode)
+{
+  namespace bpo = boost::program_options;
+  try {
+    bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+    bpo::notify(vm);
+  } catch (const bpo::error& e) {
+    std::cerr << e.what() << "\n\n"
+              << desc << '\n';
+    exitCode = 1;
+    return false;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << '\n';
+    exitCode = 0;
+    return false;
+  }
+  return true;
+}
+
+/// output stream of the per-object dump: none if name is empty, the standard
+/// output for "-", else a file with a large buffer
+class DumpStream
+{
+ public:
+  static constexpr size_t BufferSize = 1 << 20;
+
+  bool open(const std::string& name)
+  {
+    if (name.empty()) {
+      return true;
+    }
+    if (name == "-") {
+      mStream = &std::cout;
+      return true;
+    }
+    mBuffer.resize(BufferSize);
+    mFile = std::make_unique<std::ofstream>();
+    mFile->rdbuf()->pubsetbuf(mBuffer.data(), mBuffer.size());
+    mFile->open(name);
+    if (!mFile->good()) {
+      return false;
+    }
+    mStream = mFile.get();
+    return true;
+  }
+  explicit operator bool() const { return mStream != nullptr; }
+  std::ostream& operator*() { return *mStream; }
+
+ private:
+  std::vector<char> mBuffer;
+  std::unique_ptr<std::ofstream> mFile;
+  std::ostream* mStream = nullptr;
+};
+
+/// keep the canvases drawn with --draw on the screen, as the ROOT macros
+/// did, until the ROOT session is quit; nothing to wait for in batch mode
+inline void showCanvases()
+{
+  if (gROOT->IsBatch()) {
+    return;
+  }
+  if (!gApplication) {
+    TApplication::CreateApplication();
+  }
+  std::cout << "Quit ROOT (File/Quit ROOT in a canvas) to exit\n";
+  gApplication->Run(true);
+}
+
+template <typename Mapping>
+struct MappingTag {
+  using type = Mapping;
+};
+
+/// call tool with MappingTag<ChipMappingMFT> or MappingTag<ChipMappingITS>
+/// according to the detector name, "mft" or "its"
+template <typename Tool>
+int dispatchDetector(const std::string& detector, Tool&& tool)
+{
+  if (detector == "mft") {
+    return tool(MappingTag<o2::ITSMFT::ChipMappingMFT>{});
+  }
+  if (detector == "its") {
+    return tool(MappingTag<o2::ITSMFT::ChipMappingITS>{});
+  }
+  std::cerr << "Unknown detector " << detector << ", expected mft or its\n";
+  return 1;
+}
+
+} // namespace ToolUtils
+
+} // namespace MFT
+} // namespace o2
+
+#endif /* O2_MFT_TOOLUTILS */
@@ -0,0 +1,501 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   mft-check-clusters.cxx
+/// @brief  residuals of the clusters to the MC hits, compiled form of the CheckClusters.C macro
+///
+/// The cluster entries are split in contiguous ranges processed by parallel
+/// threads, each thread writes its rows in a columnar part file, the parts are
+/// concatenated in the order of the entries and merged into the ROOT ntuple at
+/// the end. The mean and RMS of the residuals are accumulated online.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TCanvas.h"
+#include "TFile.h"
+#include "TH1.h"
+#include "TTree.h"
+#include "TNtuple.h"
+#include "TROOT.h"
+
+#include "DetectorsBase/GeometryManager.h"
+#include "DataFormatsITSMFT/Cluster.h"
+#include "DataFormatsITSMFT/CompCluster.h"
+#include "DataFormatsITSMFT/TopologyDictionary.h"
+#include "ITSMFTSimulation/Hit.h"
+#include "MathUtils/Cartesian3D.h"
+#include "MathUtils/Utils.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+
+#include "MFTTestwf/ChipTransform.h"
+#include "MFTTestwf/ToolUtils.h"
+
+namespace bpo = boost::program_options;
+using namespace o2::MFT;
+
+namespace
+{
+
+/// columns of the residual ntuple, in the order of the CheckClusters.C ntuple
+enum Column { kX,
+              kY,
+              kZ,
+              kDX,
+              kDZ,
+              kLab,
+              kROF,
+              kEv,
+              kHLX,
+              kHLZ,
+              kCLX,
+              kCLZ,
+              NColumns };
+const char* ColumnNames[NColumns] = { "x", "y", "z", "dx", "dz", "lab", "rof", "ev", "hlx", "hlz", "clx", "clz" };
+
+/// columnar file: the magic, the number of columns and their names (8 bytes
+/// each), then row groups of one cluster entry each: the number of rows
+/// followed by the float values of each column in turn
+constexpr char ColumnMagic[8] = { 'M', 'F', 'T', 'R', 'E', 'S', '0', '1' };
+constexpr int ColumnNameSize = 8;
+
+/// mean and variance updated one value at a time (Welford), the partial
+/// results of the threads are merged with the pairwise formula of Chan et al.
+struct RunningStats {
+  size_t n = 0;
+  double mean = 0.;
+  double m2 = 0.;
+
+  void add(double v)
+  {
+    n++;
+    double d = v - mean;
+    mean += d / n;
+    m2 += d * (v - mean);
+  }
+  void merge(const RunningStats& other)
+  {
+    if (other.n == 0) {
+      return;
+    }
+    size_t nTot = n + other.n;
+    double d = other.mean - mean;
+    mean += d * other.n / nTot;
+    m2 += other.m2 + d * d * n * other.n / nTot;
+    n = nTot;
+  }
+  double rms() const { return n > 1 ? std::sqrt(m2 / (n - 1)) : 0.; }
+};
+
+struct ResidualSummary {
+  size_t nClusters = 0;
+  size_t nSignal = 0;
+  size_t nMissing = 0;
+  RunningStats dx;
+  RunningStats dz;
+
+  void merge(const ResidualSummary& other)
+  {
+    nClusters += other.nClusters;
+    nSignal += other.nSignal;
+    nMissing += other.nMissing;
+    dx.merge(other.dx);
+    dz.merge(other.dz);
+  }
+};
+
+struct CheckOptions {
+  std::string clusFile;
+  std::string hitFile;
+  std::string geomFile;
+  std::string dictFile;
+  std::string outFile;
+  std::string columnFile;
+  std::string dumpFile;
+  int nThreads = 1;
+  bool draw = false;
+};
+
+std::string getPartName(const std::string& name, int part)
+{
+  return name + ".part" + std::to_string(part);
+}
+
+/// the dump parts are written next to the column parts, the dump may go to the standard output
+std::string getDumpPartName(const CheckOptions& opt)
+{
+  return opt.columnFile + ".dump";
+}
+
+/// append the part files to out in turn and remove them
+bool concatenateParts(const std::string& name, int nParts, std::ostream& out)
+{
+  bool ok = true;
+  for (int i = 0; i < nParts; i++) {
+    auto partName = getPartName(name, i);
+    {
+      std::ifstream part(partName, std::ios::binary);
+      ok &= part.good();
+      if (part.good() && part.peek() != std::ifstream::traits_type::eof()) {
+        out << part.rdbuf();
+      }
+    }
+    std::remove(partName.c_str());
+  }
+  return ok;
+}
+
+/// residuals of the clusters of a range of entries, with its own copies of
+/// the trees: the ROOT objects of a thread are not shared with the others
+template <typename Mapping>
+class ResidualWorker
+{
+ public:
+  ResidualWorker(const CheckOptions& opt, const std::string& clusName, const o2::ITSMFT::TopologyDictionary* dict)
+    : mOpt(opt), mClusName(clusName), mDict(dict)
+  {
+  }
+
+  bool process(int first, int last, int part, ResidualSummary& summary)
+  {
+    std::unique_ptr<TFile> hitFile(TFile::Open(mOpt.hitFile.c_str()));
+    auto hitTree = hitFile ? (TTree*)hitFile->Get("o2sim") : nullptr;
+    std::unique_ptr<TFile> clusFile(TFile::Open(mClusName.c_str()));
+    auto clusTree = clusFile ? (TTree*)clusFile->Get("o2sim") : nullptr;
+    if (!hitTree || !clusTree) {
+      return false;
+    }
+    std::vector<o2::ITSMFT::Hit>* hitArray = nullptr;
+    hitTree->SetBranchAddress(getDetectorName<Mapping>("Hit").c_str(), &hitArray);
+    std::vector<o2::ITSMFT::Cluster>* clusArr = nullptr;
+    clusTree->SetBranchAddress(getDetectorName<Mapping>("Cluster").c_str(), &clusArr);
+    o2::dataformats::MCTruthContainer<o2::MCCompLabel>* clusLabArr = nullptr;
+    clusTree->SetBranchAddress(getDetectorName<Mapping>("ClusterMCTruth").c_str(), &clusLabArr);
+    // the pattern IDs are only dumped; the compact clusters may be encoded,
+    // the branch is then empty except for the entries which could not be
+    // encoded, the other entries are dumped without pattern ID
+    std::vector<o2::ITSMFT::CompClusterExt>* clusCompArr = nullptr;
+    auto compName = getDetectorName<Mapping>("ClusterComp");
+    if (mDict && clusTree->GetBranch(compName.c_str())) {
+      clusTree->SetBranchAddress(compName.c_str(), &clusCompArr);
+    }
+
+    std::ofstream columns(getPartName(mOpt.columnFile, part), std::ios::binary);
+    std::unique_ptr<std::ofstream> dump;
+    if (!mOpt.dumpFile.empty()) {
+      dump = std::make_unique<std::ofstream>(getPartName(getDumpPartName(mOpt), part));
+      *dump << std::fixed << std::setprecision(6);
+    }
+
+    const auto* gman = DetectorTraits<Mapping>::Geometry::Instance();
+    int lastReadHitEv = -1;
+    for (int ievC = first; ievC < last; ievC++) {
+      clusTree->GetEvent(ievC);
+      int nc = clusArr->size();
+      summary.nClusters += nc;
+      bool withComp = clusCompArr && clusCompArr->size() == clusArr->size();
+
+      // local and global positions of all the clusters, one batch per chip
+      transformClusters(*clusArr, [gman](int chip) -> const o2::Transform3D& { return gman->getMatrixT2L(chip); }, mLoc);
+      transformClusters(*clusArr, [gman](int chip) -> const o2::Transform3D& { return gman->getMatrixT2G(chip); }, mGlo);
+
+      for (auto& col : mColumns) {
+        col.clear();
+      }
+      while (nc--) {
+        const auto& c = (*clusArr)[nc];
+        auto lab = (clusLabArr->getLabels(nc))[0];
+        int trID = lab.getTrackID();
+        if (trID < 0) { // noise cluster
+          continue;
+        }
+        summary.nSignal++;
+        int chipID = c.getSensorID();
+        int ievH = lab.getEventID();
+        if (lastReadHitEv != ievH) {
+          hitTree->GetEvent(ievH);
+          lastReadHitEv = ievH;
+          indexHits(*hitArray);
+        }
+
+        float dx = 0, dz = 0;
+        Point3D<float> locH;
+        auto ih = mHitIndex.find(getHitKey(chipID, trID));
+        if (ih == mHitIndex.end()) {
+          summary.nMissing++;
+          if (dump) {
+            *dump << "# no hit (event " << ievH << ") for the cluster of track " << trID << " on chip " << chipID << '\n';
+          }
+        } else {
+          const auto& p = (*hitArray)[ih->second];
+          // mean local position of the hit
+          locH = gman->getMatrixL2G(chipID) ^ (p.GetPos()); // inverse conversion from global to local
+          auto locHsta = gman->getMatrixL2G(chipID) ^ (p.GetPosStart());
+          locH.SetXYZ(0.5 * (locH.X() + locHsta.X()), 0.5 * (locH.Y() + locHsta.Y()), 0.5 * (locH.Z() + locHsta.Z()));
+          dx = locH.X() - mLoc.x[nc];
+          dz = locH.Z() - mLoc.z[nc];
+          summary.dx.add(dx);
+          summary.dz.add(dz);
+          if (dump) {
+            dumpCluster(*dump, ievC, c, p, locH, withComp ? (*clusCompArr)[nc].getPatternID() : -1);
+          }
+        }
+        float row[NColumns] = { mGlo.x[nc], mGlo.y[nc], mGlo.z[nc], dx, dz, float(trID), float(c.getROFrame()),
+                                float(ievC), locH.X(), locH.Z(), mLoc.x[nc], mLoc.z[nc] };
+        for (int i = 0; i < NColumns; i++) {
+          mColumns[i].push_back(row[i]);
+        }
+      }
+      // one row group per entry
+      uint32_t nRows = mColumns[0].size();
+      columns.write(reinterpret_cast<const char*>(&nRows), sizeof(nRows));
+      for (const auto& col : mColumns) {
+        columns.write(reinterpret_cast<const char*>(col.data()), col.size() * sizeof(float));
+      }
+    }
+    return columns.good();
+  }
+
+ private:
+  static uint64_t getHitKey(int chip, int track) { return (uint64_t(uint32_t(chip)) << 32) | uint32_t(track); }
+
+  /// first hit of each track on each chip, as found by the scan of the macro
+  void indexHits(const std::vector<o2::ITSMFT::Hit>& hits)
+  {
+    mHitIndex.clear();
+    for (size_t i = 0; i < hits.size(); i++) {
+      mHitIndex.emplace(getHitKey(hits[i].GetDetectorID(), hits[i].GetTrackID()), i);
+    }
+  }
+
+  void dumpCluster(std::ostream& out, int entry, const o2::ITSMFT::Cluster& c, const o2::ITSMFT::Hit& p,
+                   const Point3D<float>& locH, int pattID) const
+  {
+    out << entry << ' ' << c.getSensorID() << ' ' << pattID << ' '
+        << p.GetPos().X() << ' ' << p.GetPos().Y() << ' ' << p.GetPos().Z() << ' '
+        << locH.X() << ' ' << locH.Y() << ' ' << locH.Z() << ' '
+        << c.getSigmaY2() << ' ' << c.getSigmaZ2() << ' ' << c.getSigmaYZ();
+    if (mDict && pattID >= 0 && pattID < mDict->GetSize()) {
+      out << ' ' << mDict->GetXcog(pattID) << ' ' << mDict->GetZcog(pattID)
+          << ' ' << mDict->GetErrX(pattID) << ' ' << mDict->GetErrZ(pattID);
+    }
+    out << '\n';
+  }
+
+  const CheckOptions& mOpt;
+  std::string mClusName;
+  const o2::ITSMFT::TopologyDictionary* mDict = nullptr;
+  ClusterCoordinates mLoc;
+  ClusterCoordinates mGlo;
+  std::vector<float> mColumns[NColumns];
+  std::unordered_map<uint64_t, size_t> mHitIndex;
+};
+
+/// draw the ntuple as CheckClusters.C does, the canvases are written in the
+/// ntuple file and keep their histograms after it is closed
+void drawNtuple(TNtuple& nt, TFile& out)
+{
+  const char* plots[][2] = { { "cXY", "y:x" }, { "cResiduals", "dx:dz" } };
+  for (const auto& plot : plots) {
+    auto c = new TCanvas(plot[0], plot[1]);
+    c->cd();
+    nt.Draw(plot[1]);
+    if (auto h = nt.GetHistogram()) {
+      h->SetDirectory(nullptr);
+    }
+    out.cd();
+    c->Write();
+  }
+}
+
+/// fill the ROOT ntuple from the row groups of the columnar file
+bool mergeColumns(const std::string& columnFile, const std::string& outFile, bool draw)
+{
+  std::ifstream in(columnFile, std::ios::binary);
+  char magic[sizeof(ColumnMagic)];
+  uint32_t nColumns = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&nColumns), sizeof(nColumns));
+  if (!in.good() || std::memcmp(magic, ColumnMagic, sizeof(magic)) != 0 || nColumns != NColumns) {
+    return false;
+  }
+  in.seekg(nColumns * ColumnNameSize, std::ios::cur);
+
+  TFile out(outFile.c_str(), "recreate");
+  TNtuple nt("ntc", "cluster ntuple", "x:y:z:dx:dz:lab:rof:ev:hlx:hlz:clx:clz");
+  std::vector<float> group;
+  float row[NColumns];
+  uint32_t nRows = 0;
+  while (in.read(reinterpret_cast<char*>(&nRows), sizeof(nRows))) {
+    group.resize(size_t(nRows) * NColumns);
+    if (!in.read(reinterpret_cast<char*>(group.data()), group.size() * sizeof(float))) {
+      return false;
+    }
+    for (uint32_t r = 0; r < nRows; r++) {
+      for (int i = 0; i < NColumns; i++) {
+        row[i] = group[size_t(i) * nRows + r];
+      }
+      nt.Fill(row);
+    }
+  }
+  out.cd();
+  nt.Write();
+  if (draw) {
+    drawNtuple(nt, out);
+  }
+  out.Close();
+  return true;
+}
+
+template <typename Mapping>
+int checkClusters(const CheckOptions& opt)
+{
+  using Traits = DetectorTraits<Mapping>;
+
+  auto clusName = opt.clusFile.empty() ? getDetectorOption<Mapping>("clusters.root") : opt.clusFile;
+  int nevCl = 0;
+  {
+    std::unique_ptr<TFile> clusFile(TFile::Open(clusName.c_str()));
+    auto clusTree = clusFile ? (TTree*)clusFile->Get("o2sim") : nullptr;
+    if (!clusTree) {
+      std::cerr << "Cannot read the clusters from " << clusName << " !\n";
+      return 1;
+    }
+    nevCl = clusTree->GetEntries(); // clusters in cont. readout may be grouped as few events per entry
+  }
+
+  // the dictionary gives the centre of gravity and the errors of the patterns in the dump
+  o2::ITSMFT::TopologyDictionary topdict;
+  bool withDict = !opt.dumpFile.empty() && std::ifstream(opt.dictFile).good();
+  if (withDict) {
+    topdict.ReadBinaryFile(opt.dictFile);
+  }
+
+  // the matrices are cached before the threads start, they are then only read
+  o2::Base::GeometryManager::loadGeometry(opt.geomFile, "FAIRGeom");
+  auto gman = Traits::Geometry::Instance();
+  gman->fillMatrixCache(o2::utils::bit2Mask(o2::TransformType::T2L, o2::TransformType::T2G, o2::TransformType::L2G));
+
+  int nThreads = std::max(1, std::min(opt.nThreads, nevCl));
+  if (nThreads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+  std::vector<ResidualSummary> summaries(nThreads);
+  std::vector<char> ok(nThreads, 0);
+  auto worker = [&](int part) {
+    ResidualWorker<Mapping> w(opt, clusName, withDict ? &topdict : nullptr);
+    int first = int(int64_t(nevCl) * part / nThreads);
+    int last = int(int64_t(nevCl) * (part + 1) / nThreads);
+    ok[part] = w.process(first, last, part, summaries[part]);
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < nThreads; i++) {
+    threads.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto& t : threads) {
+    t.join();
+  }
+  bool allOK = std::all_of(ok.begin(), ok.end(), [](char v) { return v != 0; });
+
+  // the parts follow each other in the order of the entries
+  {
+    std::ofstream columns(opt.columnFile, std::ios::binary);
+    uint32_t nColumns = NColumns;
+    columns.write(ColumnMagic, sizeof(ColumnMagic));
+    columns.write(reinterpret_cast<const char*>(&nColumns), sizeof(nColumns));
+    for (auto name : ColumnNames) {
+      char padded[ColumnNameSize] = {};
+      std::strncpy(padded, name, ColumnNameSize);
+      columns.write(padded, ColumnNameSize);
+    }
+    allOK &= concatenateParts(opt.columnFile, nThreads, columns);
+  }
+  if (!opt.dumpFile.empty()) {
+    ToolUtils::DumpStream dump;
+    if (dump.open(opt.dumpFile)) {
+      *dump << "# entry chip pattern hit_gx hit_gy hit_gz hit_lx hit_ly hit_lz sy2 sz2 syz cog_x cog_z err_x err_z\n";
+      concatenateParts(getDumpPartName(opt), nThreads, *dump);
+    } else {
+      std::cerr << "Cannot open the " << opt.dumpFile << " file !\n";
+      allOK = false;
+    }
+  }
+  if (!allOK) {
+    std::cerr << "Cannot read the hits from " << opt.hitFile << " or write the columns in " << opt.columnFile << " !\n";
+    return 1;
+  }
+  if (opt.draw && opt.outFile.empty()) {
+    std::cerr << "Nothing to draw without the ntuple, --output is empty\n";
+  }
+  if (!opt.outFile.empty() && !mergeColumns(opt.columnFile, opt.outFile, opt.draw)) {
+    std::cerr << "Cannot merge the columns of " << opt.columnFile << " in " << opt.outFile << " !\n";
+    return 1;
+  }
+
+  ResidualSummary total;
+  for (const auto& s : summaries) {
+    total.merge(s);
+  }
+  std::cout << Traits::Name << " clusters checked: " << nevCl << " entries with " << nThreads << " threads, "
+            << total.nClusters << " clusters, " << total.nSignal << " from signal, " << total.nMissing << " without hit\n"
+            << "  dx: mean " << total.dx.mean << " cm, RMS " << total.dx.rms() << " cm\n"
+            << "  dz: mean " << total.dz.mean << " cm, RMS " << total.dz.rms() << " cm\n"
+            << "  columns in " << opt.columnFile;
+  if (!opt.outFile.empty()) {
+    std::cout << ", ntuple in " << opt.outFile;
+  }
+  std::cout << '\n';
+  if (opt.draw && !opt.outFile.empty()) {
+    ToolUtils::showCanvases();
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  CheckOptions opt;
+  std::string detector;
+
+  bpo::options_description desc("mft-check-clusters: residuals of the clusters to the MC hits");
+  desc.add_options()(
+    "help,h", "Print this help")(
+    "detector", bpo::value<std::string>(&detector)->default_value("mft"), "Detector: mft or its")(
+    "clusters", bpo::value<std::string>(&opt.clusFile)->default_value(""), "Cluster file (default <detector>clusters.root)")(
+    "hits", bpo::value<std::string>(&opt.hitFile)->default_value("o2sim.root"), "MC hit file")(
+    "geometry", bpo::value<std::string>(&opt.geomFile)->default_value("O2geometry.root"), "Geometry file")(
+    "dictionary", bpo::value<std::string>(&opt.dictFile)->default_value("complete_dictionary.bin"), "Topology dictionary, for the dump")(
+    "threads", bpo::value<int>(&opt.nThreads)->default_value(1), "Number of threads sharing the cluster entries")(
+    "columns", bpo::value<std::string>(&opt.columnFile)->default_value("CheckClusters.col"), "Columnar output file with the residuals")(
+    "output", bpo::value<std::string>(&opt.outFile)->default_value("CheckClusters.root"), "ROOT file where the columns are merged in the ntuple, empty to skip the merge")(
+    "dump", bpo::value<std::string>(&opt.dumpFile)->default_value(""), "Dump the matched hits and clusters in this text file, - for the standard output")(
+    "draw", bpo::bool_switch(&opt.draw), "Draw the cluster positions and the residuals, as the CheckClusters.C macro, the canvases are saved with the ntuple");
+
+  bpo::variables_map vm;
+  int exitCode = 0;
+  if (!ToolUtils::parseOptions(argc, argv, desc, vm, exitCode)) {
+    return exitCode;
+  }
+  return ToolUtils::dispatchDetector(detector, [&opt](auto tag) {
+    return checkClusters<typename decltype(tag)::type>(opt);
+  });
+}
@@ -0,0 +1,215 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   mft-check-topologies.cxx
+/// @brief  build the topology dictionaries of all, signal and noise clusters,
+///         compiled form of the CheckTopologies.C macro
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TCanvas.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1F.h"
+#include "TAxis.h"
+
+#include "DetectorsBase/GeometryManager.h"
+#include "DataFormatsITSMFT/Cluster.h"
+#include "DataFormatsITSMFT/ClusterTopology.h"
+#include "ITSMFTReconstruction/BuildTopologyDictionary.h"
+#include "ITSMFTSimulation/Hit.h"
+#include "MathUtils/Cartesian3D.h"
+#include "MathUtils/Utils.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+
+#include "MFTTestwf/ChipTransform.h"
+#include "MFTTestwf/ToolUtils.h"
+
+namespace bpo = boost::program_options;
+using namespace o2::MFT;
+
+namespace
+{
+
+struct TopologyOptions {
+  std::string clusFile;
+  std::string hitFile;
+  std::string geomFile;
+  std::string histFile;
+  float threshold = 0.0001f;
+  bool draw = false;
+};
+
+void writeDictionary(o2::ITSMFT::BuildTopologyDictionary& dict, const std::string& name, float threshold,
+                     TFile& histFile, bool draw)
+{
+  dict.setThreshold(threshold);
+  dict.groupRareTopologies();
+  dict.printDictionaryBinary(name + "_dictionary.bin");
+  dict.printDictionary(name + "_dictionary.txt");
+  dict.saveDictionaryRoot((name + "_dictionary.root").c_str());
+
+  histFile.cd();
+  auto h = (TH1F*)dict.mHdist.Clone(("h_" + name).c_str());
+  h->SetTitle("Topology distribution");
+  h->GetXaxis()->SetTitle("Topology ID");
+  h->Write();
+  if (draw) {
+    // as CheckTopologies.C, the histogram outlives the file for the display
+    h->SetDirectory(nullptr);
+    auto c = new TCanvas(("c_" + name).c_str(), ("Distribution of the " + name + " topologies").c_str());
+    c->cd();
+    c->SetLogy();
+    h->SetFillColor(kRed);
+    h->SetFillStyle(3005);
+    h->Draw("hist");
+    histFile.cd();
+    c->Write();
+  }
+}
+
+template <typename Mapping>
+int checkTopologies(const TopologyOptions& opt)
+{
+  using o2::ITSMFT::BuildTopologyDictionary;
+  using o2::ITSMFT::Cluster;
+  using o2::ITSMFT::ClusterTopology;
+  using o2::ITSMFT::Hit;
+  using Traits = DetectorTraits<Mapping>;
+
+  o2::Base::GeometryManager::loadGeometry(opt.geomFile, "FAIRGeom");
+  auto gman = Traits::Geometry::Instance();
+  gman->fillMatrixCache(o2::utils::bit2Mask(o2::TransformType::T2L, o2::TransformType::L2G));
+
+  std::unique_ptr<TFile> hitFile(TFile::Open(opt.hitFile.c_str()));
+  auto hitTree = hitFile ? (TTree*)hitFile->Get("o2sim") : nullptr;
+  auto clusName = opt.clusFile.empty() ? getDetectorOption<Mapping>("clusters.root") : opt.clusFile;
+  std::unique_ptr<TFile> clusFile(TFile::Open(clusName.c_str()));
+  auto clusTree = clusFile ? (TTree*)clusFile->Get("o2sim") : nullptr;
+  if (!hitTree || !clusTree) {
+    std::cerr << "Cannot read the hits from " << opt.hitFile << " or the clusters from " << clusName << " !\n";
+    return 1;
+  }
+
+  std::vector<Hit>* hitArray = nullptr;
+  hitTree->SetBranchAddress(getDetectorName<Mapping>("Hit").c_str(), &hitArray);
+  std::vector<Cluster>* clusArr = nullptr;
+  clusTree->SetBranchAddress(getDetectorName<Mapping>("Cluster").c_str(), &clusArr);
+  o2::dataformats::MCTruthContainer<o2::MCCompLabel>* clusLabArr = nullptr;
+  clusTree->SetBranchAddress(getDetectorName<Mapping>("ClusterMCTruth").c_str(), &clusLabArr);
+
+  // topology dictionaries: 1) all clusters 2) signal clusters only 3) noise clusters only
+  BuildTopologyDictionary completeDictionary;
+  BuildTopologyDictionary signalDictionary;
+  BuildTopologyDictionary noiseDictionary;
+
+  size_t nClusters = 0, nSignal = 0, nMissing = 0;
+  int nevCl = clusTree->GetEntries(); // clusters in cont. readout may be grouped as few events per entry
+  int lastReadHitEv = -1;
+  ClusterCoordinates locArr;
+  for (int ievC = 0; ievC < nevCl; ievC++) {
+    clusTree->GetEvent(ievC);
+    int nc = clusArr->size();
+    nClusters += nc;
+
+    // local positions of all the clusters, one batch per chip
+    transformClusters(*clusArr, [gman](int chip) -> const o2::Transform3D& { return gman->getMatrixT2L(chip); }, locArr);
+
+    while (nc--) {
+      const Cluster& c = (*clusArr)[nc];
+      int chipID = c.getSensorID();
+      auto lab = (clusLabArr->getLabels(nc))[0];
+
+      int rowSpan = c.getPatternRowSpan();
+      int columnSpan = c.getPatternColSpan();
+      int nBytes = (rowSpan * columnSpan) >> 3;
+      if (((rowSpan * columnSpan) % 8) != 0)
+        nBytes++;
+      unsigned char patt[Cluster::kMaxPatternBytes];
+      c.getPattern(&patt[0], nBytes);
+      ClusterTopology topology(rowSpan, columnSpan, patt);
+
+      float dx = 0, dz = 0;
+      int trID = lab.getTrackID();
+      if (trID >= 0) { // is this cluster from hit or noise ?
+        nSignal++;
+        int ievH = lab.getEventID();
+        if (lastReadHitEv != ievH) {
+          hitTree->GetEvent(ievH);
+          lastReadHitEv = ievH;
+        }
+        const Hit* p = nullptr;
+        for (const auto& ptmp : *hitArray) {
+          if (ptmp.GetDetectorID() == chipID && ptmp.GetTrackID() == trID) {
+            p = &ptmp;
+            break;
+          }
+        }
+        if (!p) {
+          nMissing++;
+        } else {
+          // mean local position of the hit
+          auto locH = gman->getMatrixL2G(chipID) ^ (p->GetPos()); // inverse conversion from global to local
+          auto locHsta = gman->getMatrixL2G(chipID) ^ (p->GetPosStart());
+          dx = 0.5 * (locH.X() + locHsta.X()) - locArr.x[nc];
+          dz = 0.5 * (locH.Z() + locHsta.Z()) - locArr.z[nc];
+        }
+        signalDictionary.accountTopology(topology, dx, dz);
+      } else {
+        noiseDictionary.accountTopology(topology, dx, dz);
+      }
+      completeDictionary.accountTopology(topology, dx, dz);
+    }
+  }
+
+  TFile histFile(opt.histFile.c_str(), "recreate");
+  writeDictionary(completeDictionary, "complete", opt.threshold, histFile, opt.draw);
+  writeDictionary(noiseDictionary, "noise", opt.threshold, histFile, opt.draw);
+  writeDictionary(signalDictionary, "signal", opt.threshold, histFile, opt.draw);
+  histFile.Close();
+
+  std::cout << Traits::Name << " topologies: " << nevCl << " entries, " << nClusters << " clusters, "
+            << nSignal << " from signal, " << nMissing << " without hit; histograms in " << opt.histFile << '\n';
+  if (opt.draw) {
+    ToolUtils::showCanvases();
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  TopologyOptions opt;
+  std::string detector;
+
+  bpo::options_description desc("mft-check-topologies: build the topology dictionaries of all, signal and noise clusters");
+  desc.add_options()(
+    "help,h", "Print this help")(
+    "detector", bpo::value<std::string>(&detector)->default_value("mft"), "Detector: mft or its")(
+    "clusters", bpo::value<std::string>(&opt.clusFile)->default_value(""), "Cluster file (default <detector>clusters.root)")(
+    "hits", bpo::value<std::string>(&opt.hitFile)->default_value("o2sim.root"), "MC hit file")(
+    "geometry", bpo::value<std::string>(&opt.geomFile)->default_value("O2geometry.root"), "Geometry file")(
+    "threshold", bpo::value<float>(&opt.threshold)->default_value(0.0001f), "Minimum frequency of the topologies kept apart from the groups")(
+    "histograms", bpo::value<std::string>(&opt.histFile)->default_value("histograms.root"), "Output file with the topology distributions")(
+    "draw", bpo::bool_switch(&opt.draw), "Draw the topology distributions, as the CheckTopologies.C macro, the canvases are saved with the histograms");
+
+  bpo::variables_map vm;
+  int exitCode = 0;
+  if (!ToolUtils::parseOptions(argc, argv, desc, vm, exitCode)) {
+    return exitCode;
+  }
+  return ToolUtils::dispatchDetector(detector, [&opt](auto tag) {
+    return checkTopologies<typename decltype(tag)::type>(opt);
+  });
+}
@@ -0,0 +1,112 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   mft-clus-sa.cxx
+/// @brief  clusterization without the FairRunAna management, compiled form
+///         of the run_clus_mftSA.C and run_clus_itsSA.C macros
+
+#include <memory>
+#include <string>
+
+#include "TStopwatch.h"
+
+#include "DetectorsBase/GeometryManager.h"
+#include "ITSMFTReconstruction/Clusterer.h"
+#include "ITSReconstruction/ClustererTask.h"
+#include "MFTReconstruction/ClustererTask.h"
+#include "FairLogger.h"
+
+#include "MFTTestwf/ToolUtils.h"
+
+namespace bpo = boost::program_options;
+using namespace o2::MFT;
+
+namespace
+{
+
+template <typename Mapping>
+struct ClustererTaskOf;
+
+template <>
+struct ClustererTaskOf<o2::ITSMFT::ChipMappingMFT> {
+  using type = o2::MFT::ClustererTask;
+};
+
+template <>
+struct ClustererTaskOf<o2::ITSMFT::ChipMappingITS> {
+  using type = o2::ITS::ClustererTask;
+};
+
+struct ClusOptions {
+  std::string inputFile;
+  std::string outputFile;
+  std::string dictFile;
+  bool raw = false;
+  bool maskOverflow = true;
+};
+
+template <typename Mapping>
+int runClusterer(const ClusOptions& opt)
+{
+  auto input = opt.inputFile.empty() ? getDetectorOption<Mapping>("digits.root") : opt.inputFile;
+  auto output = opt.outputFile.empty() ? getDetectorOption<Mapping>("clusters.root") : opt.outputFile;
+
+  TStopwatch timer;
+  o2::Base::GeometryManager::loadGeometry(); // needed provisionary, only to write full clusters
+
+  // MC truth is kept for the comparison with the hits, one tree entry per ROF
+  auto clus = std::make_unique<typename ClustererTaskOf<Mapping>::type>(true, opt.raw);
+  if (!opt.dictFile.empty()) {
+    clus->loadDictionary(opt.dictFile.c_str());
+  }
+  clus->getClusterer().setWantCompactClusters(true); // require compact clusters with patternID
+  clus->getClusterer().setMaskOverflowPixels(opt.maskOverflow);
+  clus->getClusterer().setWantFullClusters(true); // require clusters with coordinates and full pattern
+
+  clus->run(input, output, true);
+
+  timer.Stop();
+  std::cout << DetectorTraits<Mapping>::Name << " clusters of " << input << " written in " << output << " in "
+            << timer.RealTime() << " s real, " << timer.CpuTime() << " s CPU\n";
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  ClusOptions opt;
+  std::string detector, logLevel;
+
+  bpo::options_description desc("mft-clus-sa: clusterization of MC digits or raw data without FairRunAna");
+  desc.add_options()(
+    "help,h", "Print this help")(
+    "detector", bpo::value<std::string>(&detector)->default_value("mft"), "Detector: mft or its")(
+    "input", bpo::value<std::string>(&opt.inputFile)->default_value(""), "Digit file or raw data file (default <detector>digits.root)")(
+    "output", bpo::value<std::string>(&opt.outputFile)->default_value(""), "Cluster file (default <detector>clusters.root)")(
+    "raw", bpo::bool_switch(&opt.raw), "The input is raw data")(
+    "dictionary", bpo::value<std::string>(&opt.dictFile)->default_value(""), "Topology dictionary file, none by default")(
+    "mask-overflow", bpo::value<bool>(&opt.maskOverflow)->default_value(true), "Mask the overflow pixels")(
+    "log-level", bpo::value<std::string>(&logLevel)->default_value("INFO"), "Screen log level");
+
+  bpo::variables_map vm;
+  int exitCode = 0;
+  if (!ToolUtils::parseOptions(argc, argv, desc, vm, exitCode)) {
+    return exitCode;
+  }
+
+  FairLogger* logger = FairLogger::GetLogger();
+  logger->SetLogVerbosityLevel("LOW");
+  logger->SetLogScreenLevel(logLevel.c_str());
+
+  return ToolUtils::dispatchDetector(detector, [&opt](auto tag) {
+    return runClusterer<typename decltype(tag)::type>(opt);
+  });
+}
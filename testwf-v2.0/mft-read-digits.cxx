@@ -0,0 +1,157 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// @file   mft-read-digits.cxx
+/// @brief  summary of a digit file, compiled form of the read_digits.C macro
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "DataFormatsITSMFT/ROFRecord.h"
+#include "ITSMFTBase/Digit.h"
+#include "SimulationDataFormat/RunContext.h"
+#include "SimulationDataFormat/MCTruthContainer.h"
+#include "SimulationDataFormat/MCCompLabel.h"
+
+#include "MFTTestwf/ToolUtils.h"
+
+namespace bpo = boost::program_options;
+using namespace o2::MFT;
+
+namespace
+{
+
+struct ReadOptions {
+  std::string digitFile;
+  std::string contextFile;
+  std::string dumpFile;
+  int signalCharge = 165;
+};
+
+template <typename Mapping>
+int readDigits(const ReadOptions& opt)
+{
+  using o2::ITSMFT::Digit;
+  using o2::ITSMFT::ROFRecord;
+  using o2::ITSMFT::MC2ROFRecord;
+  using Traits = DetectorTraits<Mapping>;
+
+  ToolUtils::DumpStream dump;
+  if (!dump.open(opt.dumpFile)) {
+    std::cerr << "Cannot open the " << opt.dumpFile << " file !\n";
+    return 1;
+  }
+
+  auto digitName = opt.digitFile.empty() ? getDetectorOption<Mapping>("digits.root") : opt.digitFile;
+  std::unique_ptr<TFile> digiFile(TFile::Open(digitName.c_str()));
+  auto digiTree = digiFile ? (TTree*)digiFile->Get("o2sim") : nullptr;
+  if (!digiTree) {
+    std::cerr << "Cannot read the digit tree from " << digitName << " !\n";
+    return 1;
+  }
+  std::unique_ptr<std::vector<ROFRecord>> rofs((std::vector<ROFRecord>*)digiFile->GetObjectChecked(
+    getDetectorName<Mapping>("DigitROF").c_str(), "vector<o2::ITSMFT::ROFRecord>"));
+  std::unique_ptr<std::vector<MC2ROFRecord>> mc2rofs((std::vector<MC2ROFRecord>*)digiFile->GetObjectChecked(
+    getDetectorName<Mapping>("DigitMC2ROF").c_str(), "vector<o2::ITSMFT::MC2ROFRecord>"));
+
+  std::vector<Digit>* digits = nullptr;
+  digiTree->SetBranchAddress(getDetectorName<Mapping>("Digit").c_str(), &digits);
+  o2::dataformats::MCTruthContainer<o2::MCCompLabel>* labels = nullptr;
+  digiTree->SetBranchAddress(getDetectorName<Mapping>("DigitMCTruth").c_str(), &labels);
+
+  // digits above the charge threshold are from the signal, the others from the noise
+  size_t nDigits = 0, nSignal = 0, nNoise = 0, nBadChip = 0, nLabels = 0;
+  std::vector<uint32_t> signalPerROF, noisePerROF;
+  int nEntries = digiTree->GetEntries();
+  for (int e = 0; e < nEntries; e++) {
+    digiTree->GetEntry(e);
+    nDigits += digits->size();
+    nLabels += labels->getNElements();
+    for (const auto& d : *digits) {
+      if (d.getChipIndex() >= Traits::NChips) {
+        nBadChip++;
+        continue;
+      }
+      // each vector reaches the last RO frame of its own digits only
+      auto rof = d.getROFrame();
+      bool signal = d.getCharge() > opt.signalCharge;
+      auto& perROF = signal ? signalPerROF : noisePerROF;
+      if (rof >= perROF.size()) {
+        perROF.resize(rof + 1, 0);
+      }
+      perROF[rof]++;
+      (signal ? nSignal : nNoise)++;
+    }
+  }
+
+  auto firedROFs = [](const std::vector<uint32_t>& counts) {
+    return std::count_if(counts.begin(), counts.end(), [](uint32_t n) { return n > 0; });
+  };
+  std::cout << Traits::Name << " digits: " << nEntries << " entries, " << nDigits << " digits, "
+            << nLabels << " MC labels, " << nBadChip << " with chip ID >= " << Traits::NChips << '\n'
+            << "  signal: " << nSignal << " digits in " << firedROFs(signalPerROF) << " RO frames\n"
+            << "  noise: " << nNoise << " digits in " << firedROFs(noisePerROF) << " RO frames\n"
+            << "  " << (rofs ? rofs->size() : 0) << " ROF records, "
+            << (mc2rofs ? mc2rofs->size() : 0) << " MC2ROF records\n";
+
+  if (!opt.contextFile.empty()) {
+    std::unique_ptr<TFile> rcFile(TFile::Open(opt.contextFile.c_str()));
+    auto runContext = rcFile ? (o2::steer::RunContext*)rcFile->GetObjectChecked("RunContext", "o2::steer::RunContext") : nullptr;
+    if (runContext) {
+      std::cout << "  " << runContext->getEventRecords().size() << " event records, "
+                << runContext->getEventParts().size() << " event parts, "
+                << runContext->getNCollisions() << " collisions\n";
+    } else {
+      std::cerr << "Cannot read the run context from " << opt.contextFile << " !\n";
+    }
+  }
+
+  if (dump) {
+    *dump << "# rof signal noise\n";
+    auto count = [](const std::vector<uint32_t>& counts, size_t rof) { return rof < counts.size() ? counts[rof] : 0; };
+    for (size_t rof = 0; rof < std::max(signalPerROF.size(), noisePerROF.size()); rof++) {
+      if (count(signalPerROF, rof) || count(noisePerROF, rof)) {
+        *dump << rof << ' ' << count(signalPerROF, rof) << ' ' << count(noisePerROF, rof) << '\n';
+      }
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  ReadOptions opt;
+  std::string detector;
+
+  bpo::options_description desc("mft-read-digits: summary of a digit file");
+  desc.add_options()(
+    "help,h", "Print this help")(
+    "detector", bpo::value<std::string>(&detector)->default_value("mft"), "Detector: mft or its")(
+    "digits", bpo::value<std::string>(&opt.digitFile)->default_value(""), "Digit file (default <detector>digits.root)")(
+    "context", bpo::value<std::string>(&opt.contextFile)->default_value("collisioncontext.root"), "Collision context file, empty to skip it")(
+    "signal-charge", bpo::value<int>(&opt.signalCharge)->default_value(165), "Digits with a larger charge are counted as signal")(
+    "dump", bpo::value<std::string>(&opt.dumpFile)->default_value(""), "Dump the signal and noise digits per RO frame in this text file, - for the standard output");
+
+  bpo::variables_map vm;
+  int exitCode = 0;
+  if (!ToolUtils::parseOptions(argc, argv, desc, vm, exitCode)) {
+    return exitCode;
+  }
+  return ToolUtils::dispatchDetector(detector, [&opt](auto tag) {
+    return readDigits<typename decltype(tag)::type>(opt);
+  });
+}
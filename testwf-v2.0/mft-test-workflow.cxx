@@ -0,0 +1,91 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "MFTTestwf/TestWorkflow.h"
+
+using namespace o2::framework;
+
+// we need to add workflow options before including Framework/runDataProcessing
+void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
+{
+
+  int wfopt1_val = -9999;
+  std::string wfopt1_help("MFT workflow test option 1 (int value)");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-opt-1", VariantType::Int, wfopt1_val, { wfopt1_help } });
+
+  std::string wfopt2_help("MFT workflow test option 2 (default is all)");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-opt-2", VariantType::String, "all", { wfopt2_help } });
+
+  std::string packed_help("Send the digits to the clusterer in the packed structure-of-arrays format");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-packed-digits", VariantType::Bool, false, { packed_help } });
+
+  std::string noise_help("Remove the digits of noisy pixels before clustering");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-noise-filter", VariantType::Bool, false, { noise_help } });
+
+  std::string fused_help("Run a chain of devices in a single process: reader-clusterer-writer, reader-clusterer or clusterer-writer (default is none)");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-fused-chain", VariantType::String, "", { fused_help } });
+
+  std::string readers_help("Number of digit readers sharing the input files, merged back in the order of the files");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-digit-readers", VariantType::Int, 1, { readers_help } });
+
+  std::string learn_help("Learn the topology dictionary from the clusters, not with a chain fused with the writer");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-learn-dictionary", VariantType::Bool, false, { learn_help } });
+
+  std::string detector_help("Detector of the digits: mft, or its for the reader, clusterer and writer alone");
+  workflowOptions.push_back(
+    ConfigParamSpec{ "mft-detector", VariantType::String, "mft", { detector_help } });
+}
+
+#include "Framework/runDataProcessing.h"
+
+WorkflowSpec defineDataProcessing(ConfigContext const& configcontext)
+{
+
+  auto wfopt1_val = configcontext.options().get<int>("mft-opt-1");
+  LOG(INFO) << "MFT workflow test option 1 = " << wfopt1_val;
+
+  auto usePacked = configcontext.options().get<bool>("mft-packed-digits");
+  LOG(INFO) << "MFT workflow with packed digits = " << usePacked;
+
+  auto detector = configcontext.options().get<std::string>("mft-detector");
+  if (detector == "its") {
+    LOG(INFO) << "MFT workflow running the ITS reader, clusterer and writer";
+    return std::move(o2::MFT::TestWorkflow::getITSWorkflow(usePacked));
+  }
+
+  auto useNoiseFilter = configcontext.options().get<bool>("mft-noise-filter");
+  LOG(INFO) << "MFT workflow with noise filter = " << useNoiseFilter;
+
+  auto fusedChain = configcontext.options().get<std::string>("mft-fused-chain");
+  if (!fusedChain.empty() && fusedChain != "reader-clusterer-writer" &&
+      fusedChain != "reader-clusterer" && fusedChain != "clusterer-writer") {
+    LOG(ERROR) << "Unknown chain of devices to fuse: " << fusedChain;
+    fusedChain.clear();
+  }
+  LOG(INFO) << "MFT workflow with fused chain = " << (fusedChain.empty() ? "none" : fusedChain);
+
+  auto nReaders = configcontext.options().get<int>("mft-digit-readers");
+  if (nReaders < 1 || fusedChain.find("reader") != std::string::npos) {
+    nReaders = 1;
+  }
+  LOG(INFO) << "MFT workflow with digit readers = " << nReaders;
+
+  auto learnDictionary = configcontext.options().get<bool>("mft-learn-dictionary");
+  LOG(INFO) << "MFT workflow with dictionary learning = " << learnDictionary;
+
+  return std::move(o2::MFT::TestWorkflow::getWorkflow(usePacked, useNoiseFilter, fusedChain, nReaders, learnDictionary));
+}